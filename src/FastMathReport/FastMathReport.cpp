@@ -0,0 +1,195 @@
+#include "../common/Include.hpp"
+#include "../common/FastMath.hpp"
+#include "../common/PolynomialDrive.hpp"
+#include "../common/Comb.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Measures every FastMath tier against <cmath>: worst absolute and relative
+// error over a sweep of each function's useful range, and time per call over
+// a large buffer. Then times FrogBlock, in both anti-aliasing modes, and
+// Comb built on each tier. Use it to decide what an app's x_mathTier can be.
+//
+
+static constexpr size_t x_numPoints = 1 << 20;
+static constexpr size_t x_numRepeats = 16;
+
+struct Sweep
+{
+    const char* m_name;
+    double m_lo;
+    double m_hi;
+    double (*m_exact)(double);
+};
+
+static double ExactSin2Pi(double x)
+{
+    return std::sin(2 * M_PI * x);
+}
+
+static const Sweep s_sweeps[] =
+{
+    {"Tanh", -8.0, 8.0, [](double x) { return std::tanh(x); }},
+    {"Exp2", -20.0, 20.0, [](double x) { return std::exp2(x); }},
+    {"Log2", 1e-4, 1e4, [](double x) { return std::log2(x); }},
+    {"Exp", -10.0, 10.0, [](double x) { return std::exp(x); }},
+    {"Sin2Pi", -4.0, 4.0, ExactSin2Pi},
+    {"Floor", -1000.0, 1000.0, [](double x) { return std::floor(x); }},
+    {"LogCosh", -20.0, 20.0, [](double x) { return std::log(std::cosh(x)); }},
+};
+
+template<MathTier Tier>
+static float Evaluate(size_t which, float x)
+{
+    typedef FastMath<Tier> Math;
+    switch (which)
+    {
+        case 0: return Math::Tanh(x);
+        case 1: return Math::Exp2(x);
+        case 2: return Math::Log2(x);
+        case 3: return Math::Exp(x);
+        case 4: return Math::Sin2Pi(x);
+        case 5: return Math::Floor(x);
+        default: return Math::LogCosh(x);
+    }
+}
+
+// Each function gets its own loop so the switch is hoisted out of the timing.
+//
+template<MathTier Tier, size_t Which>
+static double TimeOne(const std::vector<float>& in, std::vector<float>& out)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t repeat = 0; repeat < x_numRepeats; repeat++)
+    {
+        for (size_t i = 0; i < in.size(); i++)
+        {
+            out[i] = Evaluate<Tier>(Which, in[i]);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (in.size() * x_numRepeats);
+}
+
+template<MathTier Tier>
+static double Time(size_t which, const std::vector<float>& in, std::vector<float>& out)
+{
+    switch (which)
+    {
+        case 0: return TimeOne<Tier, 0>(in, out);
+        case 1: return TimeOne<Tier, 1>(in, out);
+        case 2: return TimeOne<Tier, 2>(in, out);
+        case 3: return TimeOne<Tier, 3>(in, out);
+        case 4: return TimeOne<Tier, 4>(in, out);
+        case 5: return TimeOne<Tier, 5>(in, out);
+        default: return TimeOne<Tier, 6>(in, out);
+    }
+}
+
+// Log2 is swept geometrically, the rest linearly.
+//
+static std::vector<float> MakeInput(size_t which)
+{
+    const Sweep& sweep = s_sweeps[which];
+    std::vector<float> in(x_numPoints);
+    for (size_t i = 0; i < x_numPoints; i++)
+    {
+        double t = static_cast<double>(i) / (x_numPoints - 1);
+        in[i] = which == 2
+            ? static_cast<float>(sweep.m_lo * std::pow(sweep.m_hi / sweep.m_lo, t))
+            : static_cast<float>(sweep.m_lo + t * (sweep.m_hi - sweep.m_lo));
+    }
+
+    return in;
+}
+
+template<MathTier Tier>
+static void Report(const char* tierName, size_t which)
+{
+    const Sweep& sweep = s_sweeps[which];
+    std::vector<float> in = MakeInput(which);
+    std::vector<float> out(in.size());
+
+    double maxAbs = 0;
+    double maxRel = 0;
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        double exact = sweep.m_exact(in[i]);
+        double error = std::abs(static_cast<double>(Evaluate<Tier>(which, in[i])) - exact);
+        maxAbs = std::max(maxAbs, error);
+        if (1e-3 < std::abs(exact))
+        {
+            maxRel = std::max(maxRel, error / std::abs(exact));
+        }
+    }
+
+    double ns = Time<Tier>(which, in, out);
+    printf("%-8s %-10s %12.3e %12.3e %10.2f\n", sweep.m_name, tierName, maxAbs, maxRel, ns);
+}
+
+template<typename Block>
+static double TimeBlock(Block& block, const std::vector<float>& in, std::vector<float>& out)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset + FrogBlock::x_maxBlockSize <= in.size(); offset += FrogBlock::x_maxBlockSize)
+    {
+        block.ProcessBlock(in.data() + offset, out.data() + offset, FrogBlock::x_maxBlockSize);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / in.size();
+}
+
+template<typename CombType>
+static double TimeComb(CombType& comb, const std::vector<float>& in, std::vector<float>& out)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        out[i] = comb.Process(in[i]);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / in.size();
+}
+
+template<MathTier Tier>
+static void ReportBlocks(const char* tierName)
+{
+    std::vector<float> in(x_numPoints);
+    std::vector<float> out(x_numPoints);
+    for (size_t i = 0; i < x_numPoints; i++)
+    {
+        in[i] = 0.8f * std::sin(2 * M_PI * 220.0 * i / 48000.0);
+    }
+
+    static BasicFrogBlock<Tier> frogBlock;
+    frogBlock.m_fuzz = 0.5f;
+    double oversampled = TimeBlock(frogBlock, in, out);
+    frogBlock.SetAntiAlias(1.0f);
+    double antiderivative = TimeBlock(frogBlock, in, out);
+    static BasicComb<Tier> comb;
+    comb.m_feedback = 0.9f;
+    printf("%-10s FrogBlock 2x %8.2f   FrogBlock ADAA %8.2f   Comb %8.2f ns/sample\n", tierName, oversampled, antiderivative, TimeComb(comb, in, out));
+}
+
+int main()
+{
+    printf("%-8s %-10s %12s %12s %10s\n", "function", "tier", "max abs", "max rel", "ns/call");
+    for (size_t which = 0; which < sizeof(s_sweeps) / sizeof(s_sweeps[0]); which++)
+    {
+        Report<MathTier::Reference>("Reference", which);
+        Report<MathTier::Balanced>("Balanced", which);
+        Report<MathTier::Fast>("Fast", which);
+    }
+
+    printf("\n");
+    ReportBlocks<MathTier::Reference>("Reference");
+    ReportBlocks<MathTier::Balanced>("Balanced");
+    ReportBlocks<MathTier::Fast>("Fast");
+    return 0;
+}
@@ -1,9 +1,11 @@
 #include "../common/Include.hpp"
 #include "Froggers.hpp"
 
+static_assert(sizeof(App<Froggers>) <= App<Froggers>::x_maxSize, "Froggers must fit in AXI SRAM");
+
 int main(void)
 {
-    App<Froggers> app;
+    static App<Froggers> app;
     app.LetsFuckingDoThisShit();
     return 0;
 }
@@ -2,170 +2,627 @@
 
 #include "../common/Include.hpp"
 #include "../common/Comb.hpp"
+#include "../common/CombBank.hpp"
+#include "../common/Convolver.hpp"
+#include "../common/FileSource.hpp"
+#include "../common/Looper.hpp"
 #include "../common/PolynomialDrive.hpp"
 #include "../common/ResonantBump.hpp"
 #include "../common/Marbles.hpp"
+#include "../common/ParamSchema.hpp"
+#include "../common/Protection.hpp"
+#include "../common/StaticGraph.hpp"
+#include "../common/Bypass.hpp"
+#include "../common/ClockTracker.hpp"
+#include "../common/DeferredWork.hpp"
+#include "../common/Trace.hpp"
 
 #include <tuple>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
 
 using namespace daisy;
 
 struct Froggers
 {
+    static constexpr size_t x_filterPage = 0;
+    static constexpr size_t x_drivePage = 1;
+    static constexpr size_t x_bankPage = 2;
+    static constexpr size_t x_loopPage = 3;
+    static constexpr size_t x_clockPage = 4;
+    static constexpr size_t x_numPages = 5;
+    static constexpr size_t x_numParams = 31;
+    static constexpr size_t x_numBankVoices = 4;
+
+    // Accuracy of tanh, sine and floor in the drive and comb; see FastMath.hpp.
+    //
+    static constexpr MathTier x_mathTier = MathTier::Reference;
+
+    using FrogBlockType = BasicFrogBlock<x_mathTier>;
+    using CombType = BasicComb<x_mathTier>;
+
     Page* m_filterParams;
     Page* m_driveParams;
+    Page* m_bankParams;
+    Page* m_loopParams;
+    Page* m_clockParams;
+
+    using Schema = ParamSchema<Froggers, x_numParams, x_numPages>;
+    Schema m_schema;
+    static const ParamSpec<Froggers> x_params[];
+
+    // Knob reads, curves and the drive's coefficient design, computed off the
+    // audio interrupt by m_deferred and applied at the top of the next block.
+    //
+    struct ControlFrame
+    {
+        Schema::Frame m_params;
+        float m_driveCoefs[PolynomialDrive::x_numCoefs];
+    };
+
+    DeferredWork<ControlFrame> m_deferred;
+    const ControlFrame* m_controlFrame;
+
+    // The coefficient design is only rerun when GAIN or SHAPE move. These
+    // belong to the deferred job; frames get a copy.
+    //
+    float m_driveKnobs[2];
+    float m_driveCoefs[PolynomialDrive::x_numCoefs];
+    bool m_driveCoefsValid;
 
+    // PureDelay -> Comb -> CombBank -> ResonantBump, inlined into one
+    // per-sample loop. The references name the stages for the parameter table.
+    // All but the delay drop out of the loop at neutral settings (COMQ
+    // centred, BNKM 0, BUPR 0).
+    //
+    using FilterChain = Chain<PureDelay, Bypassable<CombType>, Bypassable<CombBank<x_numBankVoices>>, Bypassable<ResonantBump>>;
 
-    RuntimeParam m_pureDelayFreq;
-    RuntimeParam m_bumpFreq;
-    RuntimeParam m_bumpResonance;
-    RuntimeParam m_bumpWidth;
-    RuntimeParam m_comf;
-    RuntimeParam m_comq;
-    RuntimeParam m_cmlp;
+    FilterChain m_filters;
+    PureDelay& m_pureDelay;
+    CombType& m_comFilter;
+    CombBank<x_numBankVoices>& m_combBank;
+    ResonantBump& m_resonantBump;
 
-    RuntimeParam m_srr1;
-    RuntimeParam m_srr2;
-    RuntimeParam m_fuzz;
-    RuntimeParam m_digr;
-    RuntimeParam m_hash;
+    FrogBlockType m_frogBlock;
 
-    ResonantBump m_resonantBump;
-    Comb m_comFilter;    
-    PureDelay m_pureDelay;
+    // Cabinet or body IR after the filters, read from the SD card at startup.
+    //
+    static constexpr const char* x_impulsePath = "froggers_ir.wav";
+    Convolver m_convolver;
 
-    FrogBlock m_frogBlock;
+    // Buttons 1 to 3 are the looper's record, reverse and stop. LSRC picks
+    // whether it loops the input, with playback running through the whole
+    // chain, or the output, with playback added after it.
+    //
+    Looper m_looper;
+    bool m_loopOutput;
+    volatile bool m_loopRecordPending;
+    volatile bool m_loopReversePending;
+    volatile bool m_loopStopPending;
 
     Marbles m_marbles;
+    size_t m_marblesStepOffset;
+    volatile bool m_marblesStepPending;
+
+    // With SYNC up and the gate clock locked, the delay and comb times are
+    // divisions of the beat and Marbles steps on the beat grid instead of on
+    // raw edges. The synced times override the DELF and COMF rows, so they
+    // glide through the same smoothers as the knobs, and glide back to the
+    // knobs when the clock drops.
+    //
+    static constexpr size_t x_numDelayDivisions = 10;
+    static constexpr float x_delayDivisions[x_numDelayDivisions] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32};
+    static constexpr size_t x_numStepRates = 6;
+    static constexpr float x_stepRates[x_numStepRates] = {0.25f, 0.5f, 1, 2, 3, 4};
+    static constexpr size_t x_minCombDivisionLog = 4;
+    static constexpr size_t x_numCombDivisions = 9;
+
+    // DELF's and COMF's rows in x_params.
+    //
+    static constexpr size_t x_delayRow = 0;
+    static constexpr size_t x_combRow = 4;
 
-    float Alpha(float natFreq)
+    const ClockTracker* m_clock;
+    bool m_sync;
+    bool m_synced;
+    float m_delayDivision;
+    float m_combDivision;
+    float m_stepRate;
+
+    // Knob-to-DSP curves, tabulated at compile time. Frequencies are in
+    // cycles per sample at 48kHz.
+    //
+    struct AudioFreqRange
     {
-        return 1.0f - std::exp(-2.0f * M_PI * natFreq);
-    }
+        static constexpr double x_min = 20.0 / 48000;
+        static constexpr double x_max = 20000.0 / 48000;
+    };
 
-    void ReadParamsBlock()
+    struct CombFreqRange
     {
-        m_pureDelayFreq.SetTarget(PhaseUtils::ExpParam::Compute(20.0f / 48000.0, 20000.0f / 48000.0, m_filterParams->GetParam(0)));
+        static constexpr double x_min = 20.0 / 48000;
+        static constexpr double x_max = 10000.0 / 48000;
+    };
 
-        // Resonant bump parameters
-        // Frequency: 20Hz to 20000Hz
-        //
-        float bumpFreq = PhaseUtils::ExpParam::Compute(20.0f / 48000, 20000.0f / 48000, m_filterParams->GetParam(1));
-        m_bumpFreq.SetTarget(bumpFreq);
-        
-        // Resonance: 0.0 = transparent (gain 1.0), 1.0 = +20dB boost (gain 10.0)
-        // Controls height of the bump
-        //
-        float resonanceKnob = m_filterParams->GetParam(2);
-        float bumpGain = PhaseUtils::ExpParam::Compute(1.0f, 10.0f, resonanceKnob);
-        m_bumpResonance.SetTarget(bumpGain);
-        
-        // Width: 0.0 = wide (Q 0.1), 1.0 = narrow (Q 10.0)
-        // Controls width/bandwidth of the bump
-        //
-        float bumpQ = PhaseUtils::ExpParam::Compute(0.1f, 10.0f, m_filterParams->GetParam(3));
-        m_bumpWidth.SetTarget(bumpQ);
-        
-        float comf = PhaseUtils::ExpParam::Compute(20 / 48000.0, 10000.0 / 48000.0, m_filterParams->GetParam(4));
-        m_comf.SetTarget(comf);
-        m_comq.SetTarget(Comb::GetFeedback(m_filterParams->GetParam(5)));
-        float cmlp = PhaseUtils::ExpParam::Compute(4 * comf, 20000.0 / 48000.0, m_filterParams->GetParam(6));
-        m_cmlp.SetTarget(Alpha(cmlp));
+    struct CutoffRange
+    {
+        static constexpr double x_min = 20.0 / 48000;
+        static constexpr double x_max = 40000.0 / 48000;
+    };
 
-        m_srr1.SetTarget(1e-2 + PhaseUtils::ZeroedExpParam::Compute(10.0,  1 - m_driveParams->GetParam(2)));
-        m_srr2.SetTarget(1e-2 + PhaseUtils::ZeroedExpParam::Compute(10.0,  1 - m_driveParams->GetParam(3)));
-        m_digr.SetTarget(m_driveParams->GetParam(4));
-        m_hash.SetTarget(m_driveParams->GetParam(5));
-        m_fuzz.SetTarget(m_driveParams->GetParam(6));
+    struct BumpGainRange
+    {
+        static constexpr double x_min = 1.0;
+        static constexpr double x_max = 10.0;
+    };
 
-        m_frogBlock.m_polynomialDrive.SetGain(m_driveParams->GetParam(0));
-        m_frogBlock.m_polynomialDrive.SetCoefs(m_driveParams->GetParam(1));
+    struct BumpQRange
+    {
+        static constexpr double x_min = 0.1;
+        static constexpr double x_max = 10.0;
+    };
+
+    struct LoopSpeedRange
+    {
+        static constexpr double x_min = 1.0 / Looper::x_maxSpeed;
+        static constexpr double x_max = Looper::x_maxSpeed;
+    };
+
+    struct SampleRateReducerCurve
+    {
+        static constexpr double Compute(double x)
+        {
+            return 1e-2 + ZeroedExpCurve<10>::Compute(1 - x);
+        }
+    };
+
+    using AudioFreqTable = ParamTable<ExpCurve<AudioFreqRange>>;
+    using CombFreqTable = ParamTable<ExpCurve<CombFreqRange>>;
+    using CutoffAlphaTable = ParamTable<AlphaCurve<CutoffRange>>;
+    using BumpGainTable = ParamTable<ExpCurve<BumpGainRange>>;
+    using BumpQTable = ParamTable<ExpCurve<BumpQRange>>;
+    using SampleRateReducerTable = ParamTable<SampleRateReducerCurve>;
+    using LoopSpeedTable = ParamTable<ExpCurve<LoopSpeedRange>>;
+
+    // Natural logs of the frequency ratios above, relative to 20Hz.
+    //
+    static constexpr float x_logFour = ConstMath::Log(4.0);
+    static constexpr float x_logCombRatio = ConstMath::Log(CombFreqRange::x_max / CombFreqRange::x_min);
+    static constexpr float x_logAudioRatio = ConstMath::Log(AudioFreqRange::x_max / AudioFreqRange::x_min);
+    static constexpr float x_logCutoffRatio = ConstMath::Log(CutoffRange::x_max / CutoffRange::x_min);
+
+    // CMLP sweeps exponentially from 4 * COMF up to 20kHz, and COMF is itself
+    // exponential in its knob, so the cutoff is linear in log frequency and
+    // indexes the alpha table directly.
+    //
+    static float CutoffCurve(float knob, const float* pageKnobs)
+    {
+        float combLog = x_logFour + pageKnobs[4] * x_logCombRatio;
+        float cutoffLog = combLog + knob * (x_logAudioRatio - combLog);
+        return CutoffAlphaTable::Lookup(cutoffLog / x_logCutoffRatio);
     }
 
-    void UpdateParams()
+    static void ComputeControlFrame(void* context, ControlFrame* frame)
     {
-        m_pureDelay.SetDelaySamples(m_pureDelayFreq.Process());
-        m_resonantBump.SetFreq(m_bumpFreq.Process());
-        m_resonantBump.SetHeight(m_bumpResonance.Process());
-        m_resonantBump.SetWidth(m_bumpWidth.Process());
-        m_comFilter.m_delaySamples = Comb::GetDelaySamples(m_comf.Process());
-        m_comFilter.m_feedback = m_comq.Process();
-        m_comFilter.SetCutoffAlpha(m_cmlp.Process());
+        Froggers* froggers = static_cast<Froggers*>(context);
+        froggers->m_schema.ComputeFrame(&frame->m_params);
 
-        m_frogBlock.m_sampleRateReducer1.SetFreq(m_srr1.Process());
-        m_frogBlock.m_sampleRateReducer2.SetFreq(m_srr2.Process());
-        m_frogBlock.m_digitalReorganizer.SetFlip(m_digr.Process());
-        m_frogBlock.m_digitalReorganizer.SetHash(m_hash.Process());
-        m_frogBlock.m_fuzz = m_fuzz.Process();
+        const float* driveKnobs = frame->m_params.m_knobs[x_drivePage];
+        if (!froggers->m_driveCoefsValid || driveKnobs[0] != froggers->m_driveKnobs[0] || driveKnobs[1] != froggers->m_driveKnobs[1])
+        {
+            PolynomialDrive::ComputeCoefs(PolynomialDrive::GainTable::Lookup(driveKnobs[0]), driveKnobs[1], froggers->m_driveCoefs);
+            froggers->m_driveKnobs[0] = driveKnobs[0];
+            froggers->m_driveKnobs[1] = driveKnobs[1];
+            froggers->m_driveCoefsValid = true;
+            Instrumentation::Count(Instrumentation::Counter::DriveCoefRecompute);
+        }
 
-        m_marbles.UpdateParams();
+        memcpy(frame->m_driveCoefs, froggers->m_driveCoefs, sizeof(frame->m_driveCoefs));
+    }
+
+    void ReadParamsBlock()
+    {
+        // CCs the last block did not reach, because the filters did not run.
+        //
+        m_schema.ApplyRemotes(this, SIZE_MAX);
+
+        if (!m_deferred.HasFrame())
+        {
+            m_deferred.Run();
+        }
+
+        m_controlFrame = m_deferred.Acquire();
+        if (m_controlFrame)
+        {
+            m_schema.ApplyFrame(this, m_controlFrame->m_params);
+        }
+        else
+        {
+            // PendSV has not finished the frame posted last block, so this
+            // block runs on the previous one.
+            //
+            Trace::Emit(Trace::Event::ControlFrameLate, m_deferred.m_publishedSequence);
+        }
+
+        m_deferred.Post();
+    }
+
+    void UpdateParams(size_t sample)
+    {
+        m_schema.ApplyRemotes(this, sample);
+        m_schema.Smooth(this);
     }
 
     Froggers()
         : m_filterParams(nullptr)
+        , m_driveParams(nullptr)
+        , m_bankParams(nullptr)
+        , m_loopParams(nullptr)
+        , m_clockParams(nullptr)
+        , m_controlFrame(nullptr)
+        , m_driveKnobs{}
+        , m_driveCoefs{}
+        , m_driveCoefsValid(false)
+        , m_pureDelay(m_filters.Get<0>())
+        , m_comFilter(m_filters.Get<1>().m_stage)
+        , m_combBank(m_filters.Get<2>().m_stage)
+        , m_resonantBump(m_filters.Get<3>().m_stage)
+        , m_loopOutput(false)
+        , m_loopRecordPending(false)
+        , m_loopReversePending(false)
+        , m_loopStopPending(false)
+        , m_marblesStepOffset(SIZE_MAX)
+        , m_marblesStepPending(false)
+        , m_clock(nullptr)
+        , m_sync(false)
+        , m_synced(false)
+        , m_delayDivision(1)
+        , m_combDivision(1)
+        , m_stepRate(1)
     {
     }
 
     void Config(PageManager* pageManager)
     {
         m_filterParams = pageManager->AddPage();
-        // Resonant bump parameters
-        // Frequency: default 1000Hz (param 0.5 maps to ~1000Hz in 20-20000 range)
+        m_driveParams = pageManager->AddPage();
+        m_marbles.Config(pageManager);
+
+        // Added after Marbles so the earlier pages keep their indices.
         //
-        m_filterParams->InitParam("DELF", 0, 0.5f);
-        m_filterParams->InitParam("BUPF", 1, 0.5f);
-        m_filterParams->InitParam("BUPR", 2, 0.0f);
-        m_filterParams->InitParam("BUPW", 3, 0.5f);        
-        m_filterParams->InitParam("COMF", 4, 0.5f);
-        m_filterParams->InitParam("COMQ", 5, 0.5f);
-        m_filterParams->InitParam("CMLP", 6, 1.0f);
+        m_bankParams = pageManager->AddPage();
+        m_loopParams = pageManager->AddPage();
+        m_clockParams = pageManager->AddPage();
 
-        m_driveParams = pageManager->AddPage();
-        m_driveParams->InitParam("GAIN", 0, 0.0f);
-        m_driveParams->InitParam("SHAPE", 1, 0.0f);
-        m_driveParams->InitParam("SRR1", 2, 0.0f);
-        m_driveParams->InitParam("SRR2", 3, 0.0f);
-        m_driveParams->InitParam("DIGR", 4, 0.0f);
-        m_driveParams->InitParam("HASH", 5, 0.0f);
-        m_driveParams->InitParam("FUZZ", 6, 0.0f);
+        Page* pages[x_numPages] = {m_filterParams, m_driveParams, m_bankParams, m_loopParams, m_clockParams};
+        m_schema.Config(x_params, pages);
+        m_deferred.Config(ComputeControlFrame, this);
 
         m_filterParams->SetFuegoization();
         m_driveParams->SetFuegoization();
+        m_bankParams->SetFuegoization();
+        m_loopParams->SetFuegoization();
+        m_clockParams->SetFuegoization();
+    }
 
-        m_marbles.Config(pageManager);
+    void SetClock(const ClockTracker* clock)
+    {
+        m_clock = clock;
     }
 
-    void Process(AudioHandle::InputBuffer& in, AudioHandle::OutputBuffer& out, size_t size)
+    void ConfigPipeline(AudioPipeline* pipeline)
+    {
+        pipeline->AddStage<Froggers, &Froggers::ProcessLoopInput>(0, this, AudioPipeline::Mode::InPlace);
+        pipeline->AddStage<FrogBlockType, &FrogBlockType::ProcessBlock>(0, &m_frogBlock, AudioPipeline::Mode::InPlace);
+        pipeline->AddStage<Froggers, &Froggers::ProcessFilters>(0, this, AudioPipeline::Mode::InPlace);
+        pipeline->AddStage<Froggers, &Froggers::ProcessConvolver>(0, this, AudioPipeline::Mode::InPlace);
+        pipeline->AddStage<Froggers, &Froggers::ProcessLoopOutput>(0, this, AudioPipeline::Mode::InPlace);
+        pipeline->SetEmptyMode(1, AudioPipeline::EmptyMode::Silence);
+    }
+
+    void BeginBlock(size_t size)
     {
         ReadParamsBlock();
-        for (size_t i = 0; i < size; i++)
+        ApplyClock();
+
+        // Synced, beat-grid steps replace gate steps; keyboard steps still go
+        // through.
+        //
+        if (m_synced)
+        {
+            m_marblesStepOffset = m_clock->TickOffset(size, m_stepRate);
+        }
+
+        if (m_marblesStepPending)
+        {
+            m_marblesStepPending = false;
+            m_marblesStepOffset = 0;
+        }
+
+        m_marbles.ProcessBlock(size, m_marblesStepOffset);
+        m_marblesStepOffset = SIZE_MAX;
+
+        if (m_loopRecordPending)
+        {
+            m_loopRecordPending = false;
+            m_looper.Record();
+        }
+
+        if (m_loopReversePending)
+        {
+            m_loopReversePending = false;
+            m_looper.Reverse();
+        }
+
+        if (m_loopStopPending)
         {
-            out[0][i] = Process(in[0][i]);
-            out[1][i] = 0;                 
+            m_loopStopPending = false;
+            m_looper.Stop();
         }
     }
 
-    void ButtonCallback(int button)
+    // Longest division of the beat that fits each delay line. Comb times are
+    // whole samples, like COMF's; the target sits half a sample past the
+    // division so GetDelaySamples' truncation lands on it.
+    //
+    void ApplyClock()
     {
-        if (button == 0)
+        m_synced = m_sync && m_clock && m_clock->IsLocked();
+        if (!m_synced)
+        {
+            m_schema.ReleaseOverride(this, x_delayRow);
+            m_schema.ReleaseOverride(this, x_combRow);
+            return;
+        }
+
+        float period = static_cast<float>(m_clock->Period());
+
+        float delay = period / m_delayDivision;
+        while (PureDelay::x_size - 2 < delay)
+        {
+            delay *= 0.5f;
+        }
+
+        m_schema.Override(this, x_delayRow, 1.0f / delay);
+
+        float comb = period / m_combDivision;
+        while (CombType::x_size - 1 < comb)
         {
-            m_marbles.Increment();
+            comb *= 0.5f;
         }
+
+        m_schema.Override(this, x_combRow, 1.0f / (std::max(1.0f, std::floor(comb)) + 0.5f));
     }
 
-    float Process(float input)
-    {    
-        UpdateParams();
-        m_marbles.Process();
-        float output = m_frogBlock.Process(input);
+    void ProcessLoopInput(const float* input, float* output, size_t size)
+    {
+        if (!m_loopOutput)
+        {
+            m_looper.ProcessBlock(input, output, size);
+            Protection::Guard(&m_looper);
+        }
+        else if (input != output)
+        {
+            memcpy(output, input, size * sizeof(float));
+        }
+    }
 
-        output = m_pureDelay.Process(output);
-        output = m_comFilter.Process(output);
-        output = m_resonantBump.Process(output);
+    void ProcessLoopOutput(const float* input, float* output, size_t size)
+    {
+        if (m_loopOutput)
+        {
+            m_looper.ProcessBlock(input, output, size);
+            Protection::Guard(&m_looper);
+        }
+        else if (input != output)
+        {
+            memcpy(output, input, size * sizeof(float));
+        }
+    }
+
+    void ProcessFilters(const float* input, float* output, size_t size)
+    {
+        m_filters.Get<1>().UpdateBypass(size);
+        m_filters.Get<2>().UpdateBypass(size);
+        m_filters.Get<3>().UpdateBypass(size);
+
+        m_filters.ProcessBlock(input, output, size, [this](size_t sample)
+        {
+            UpdateParams(sample);
+        });
+
+        // A NaN or inf in a recursive path would latch, so clear any stage
+        // whose state has gone non-finite.
+        //
+        Protection::Guard(&m_frogBlock);
+        Protection::Guard(&m_pureDelay);
+        Protection::Guard(&m_comFilter);
+        Protection::Guard(&m_combBank);
+        Protection::Guard(&m_resonantBump);
+    }
+
+    void ProcessConvolver(const float* input, float* output, size_t size)
+    {
+        m_convolver.ProcessBlock(input, output, size);
+        Protection::Guard(&m_convolver);
+    }
+
+    // For SilenceGate: the drive feeds the filter chain, which feeds the
+    // convolver, so the tails add. A running looper never lets it sleep, so
+    // recording and playback keep time.
+    //
+    size_t TailSamples() const
+    {
+        if (m_looper.IsSounding())
+        {
+            return SIZE_MAX;
+        }
 
-        return output;
+        return m_frogBlock.TailSamples() + m_filters.TailSamples() + m_convolver.TailSamples();
+    }
+
+    // Without a card or a file, CONV does nothing.
+    //
+    void LoadFiles(bool sdMounted)
+    {
+        FileSource source;
+        if (sdMounted && source.Open(x_impulsePath))
+        {
+            m_convolver.Load(&source);
+        }
+    }
+
+    // CCs retarget the schema's rows from their sample, as if the knob had
+    // moved there.
+    //
+    void RemoteSetCallback(uint8_t page, uint8_t slot, float value, size_t sampleOffset)
+    {
+        m_schema.ScheduleRemote(page, slot, value, sampleOffset);
+    }
+
+    // The gate is read once per block, so its steps land on the first sample.
+    //
+    void GateCallback()
+    {
+        m_marblesStepOffset = 0;
+    }
+
+    // Notes step Marbles like gate pulses, at their offset.
+    //
+    void MidiCallback(const MidiEvent& event, size_t sampleOffset)
+    {
+        if (event.IsNoteOn())
+        {
+            m_marblesStepOffset = std::min(m_marblesStepOffset, sampleOffset);
+        }
+    }
+
+    void ButtonCallback(int button)
+    {
+        if (button == 0)
+        {
+            // Keyboard steps come from the control loop, so defer them to the
+            // top of the next audio block instead of touching Marbles here.
+            //
+            m_marblesStepPending = true;
+        }
+        else if (button == 1)
+        {
+            m_loopRecordPending = true;
+        }
+        else if (button == 2)
+        {
+            m_loopReversePending = true;
+        }
+        else if (button == 3)
+        {
+            m_loopStopPending = true;
+        }
     }
 };
 
+// Every Froggers control, in one place. Resonant bump frequency defaults to
+// ~1000Hz (0.5 in the 20-20000Hz range). Bump resonance goes from transparent
+// (gain 1.0) to +20dB (gain 10.0), bump width from wide (Q 0.1) to narrow
+// (Q 10.0).
+//
+// The drive page is applied per block: FrogBlock runs a block at a time and
+// ramps fuzz and hold rate across the block itself.
+//
+// The bank page tunes a 4-voice comb bank to a chord on BNKF, picked by CHRD.
+// It sits after the single comb and starts fully dry (BNKM 0). CONV is the
+// dry/wet mix of the convolver at the end of the chain, also dry by default.
+// ALIA picks the drive's anti-aliasing, 2x oversampling below half and
+// antiderivatives above; it lives here because the drive page is full (its
+// last knob is FUEG).
+//
+// The loop page sets the looper's playback level, overdub feedback, speed
+// (1/4x to 4x, 1x at centre), number of read heads and their spread, and its
+// source: the input below half, the output above.
+//
+// The clock page syncs to pulses on the gate input once SYNC is up: DDIV
+// sets the delay to 1 to 1/32 of a beat, CDIV the comb to 1/16 to 1/4096 of
+// a beat (so it tunes to a harmonic of the tempo), and MDIV steps Marbles
+// from every fourth beat to four times a beat. Either delay is halved until
+// it fits its line.
+//
+inline constexpr ParamSpec<Froggers> Froggers::x_params[] =
+{
+    {"DELF", x_filterPage, 0, 0.5f, ParamCurve<AudioFreqTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_pureDelay.SetDelaySamples(v); }},
+    {"BUPF", x_filterPage, 1, 0.5f, ParamCurve<AudioFreqTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_resonantBump.SetFreq(v); }},
+    {"BUPR", x_filterPage, 2, 0.0f, ParamCurve<BumpGainTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_resonantBump.SetHeight(v); }},
+    {"BUPW", x_filterPage, 3, 0.5f, ParamCurve<BumpQTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_resonantBump.SetWidth(v); }},
+    {"COMF", x_filterPage, 4, 0.5f, ParamCurve<CombFreqTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_comFilter.m_delaySamples = Comb::GetDelaySamples(v); }},
+    {"COMQ", x_filterPage, 5, 0.5f, ParamCurve<Comb::FeedbackTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_comFilter.m_feedback = v; }},
+    {"CMLP", x_filterPage, 6, 1.0f, Froggers::CutoffCurve, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_comFilter.SetCutoffAlpha(v); }},
+
+    {"GAIN", x_drivePage, 0, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v)
+        {
+            // The coefficient design depends on the gain too.
+            //
+            f->m_frogBlock.m_polynomialDrive.SetGain(v);
+            f->m_frogBlock.m_polynomialDrive.SetCoefTargets(f->m_controlFrame->m_driveCoefs);
+        }},
+    {"SHAPE", x_drivePage, 1, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_polynomialDrive.SetCoefTargets(f->m_controlFrame->m_driveCoefs); }},
+    {"SRR1", x_drivePage, 2, 0.0f, ParamCurve<SampleRateReducerTable::Lookup>, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_sampleRateReducer1.SetFreq(v); }},
+    {"SRR2", x_drivePage, 3, 0.0f, ParamCurve<SampleRateReducerTable::Lookup>, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_sampleRateReducer2.SetFreq(v); }},
+    {"DIGR", x_drivePage, 4, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_digitalReorganizer.SetFlip(v); }},
+    {"HASH", x_drivePage, 5, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_digitalReorganizer.SetHash(v); }},
+    {"FUZZ", x_drivePage, 6, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.m_fuzz = v; }},
+
+    {"BNKF", x_bankPage, 0, 0.3f, ParamCurve<CombFreqTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_combBank.SetFreq(v); }},
+    {"CHRD", x_bankPage, 1, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_combBank.SetChord(v); }},
+    {"BNKQ", x_bankPage, 2, 0.7f, ParamCurve<CombBank<x_numBankVoices>::FeedbackTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_combBank.SetFeedback(v); }},
+    {"BNKL", x_bankPage, 3, 0.8f, ParamCurve<CutoffAlphaTable::Lookup>, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_combBank.SetCutoffAlpha(v); }},
+    {"BNKM", x_bankPage, 4, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::OnePole,
+        [](Froggers* f, float v) { f->m_combBank.SetMix(v); }},
+    {"CONV", x_bankPage, 5, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_convolver.SetMix(v); }},
+    {"ALIA", x_bankPage, 6, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_frogBlock.SetAntiAlias(v); }},
+
+    {"LVOL", x_loopPage, 0, 0.8f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_looper.SetLevel(v); }},
+    {"LFDB", x_loopPage, 1, 0.9f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_looper.SetFeedback(v); }},
+    {"LSPD", x_loopPage, 2, 0.5f, ParamCurve<LoopSpeedTable::Lookup>, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_looper.SetSpeed(v); }},
+    {"LHDS", x_loopPage, 3, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_looper.SetHeads(v); }},
+    {"LSPR", x_loopPage, 4, 1.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_looper.SetSpread(v); }},
+    {"LSRC", x_loopPage, 5, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_loopOutput = 0.5f <= v; }},
+
+    {"SYNC", x_clockPage, 0, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_sync = 0.5f <= v; }},
+    {"DDIV", x_clockPage, 1, 0.0f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_delayDivision = x_delayDivisions[std::min(static_cast<size_t>(v * x_numDelayDivisions), x_numDelayDivisions - 1)]; }},
+    {"CDIV", x_clockPage, 2, 0.5f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_combDivision = static_cast<float>(1 << (x_minCombDivisionLog + std::min(static_cast<size_t>(v * x_numCombDivisions), x_numCombDivisions - 1))); }},
+    {"MDIV", x_clockPage, 3, 0.4f, IdentityCurve, ParamSpec<Froggers>::Smoothing::Block,
+        [](Froggers* f, float v) { f->m_stepRate = x_stepRates[std::min(static_cast<size_t>(v * x_numStepRates), x_numStepRates - 1)]; }},
+};
 
+static_assert(std::size(Froggers::x_params) == Froggers::x_numParams, "Froggers::x_numParams must match the rows of x_params");
+static_assert(ParamSpecsComplete(Froggers::x_params), "Every Froggers param needs a name, a curve and a setter");
+static_assert(ParamSpecNamed(Froggers::x_params[Froggers::x_delayRow], "DELF") && ParamSpecNamed(Froggers::x_params[Froggers::x_combRow], "COMF"), "Froggers::x_delayRow and x_combRow must point at DELF and COMF");
\ No newline at end of file
@@ -0,0 +1,679 @@
+#include "../common/Include.hpp"
+#include "../common/EQ.hpp"
+#include "../Froggers/Froggers.hpp"
+#include "../Poggers/Poggers.hpp"
+#include "HostApp.hpp"
+#include "MidiFile.hpp"
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Golden-audio regression runner. Renders fixed test signals through each app
+// and each DSP block at fixed settings and compares the result against
+// reference WAVs:
+//
+//   Golden update <dir>                  render and (re)write the references
+//   Golden check <dir> [tolerance]       render and compare, nonzero exit on mismatch
+//   Golden list                          print the case names
+//
+// The references live in reference/, checked by `make check` and rewritten by
+// `make update`. Update them only for changes that are meant to alter the
+// sound, in the same commit, so the history says which changes did. They
+// depend on the smart-grid sources in External as well as on this tree.
+//
+// baseline/ holds the cases that existed before any of the DSP was reworked,
+// rendered from the original per-sample Froggers, FrogBlock and Comb. It is
+// never updated: `make check REFERENCE_DIR=baseline` lists every case whose
+// sound has moved since, and by how much.
+//
+
+static constexpr uint32_t x_sampleRate = 48000;
+
+typedef std::vector<float> Buffer;
+
+struct Signal
+{
+    const char* m_name;
+    Buffer m_samples;
+};
+
+// Deterministic test signals. Noise comes from a fixed-seed LCG so it does not
+// depend on how RGen is seeded.
+//
+static std::vector<Signal> MakeSignals()
+{
+    std::vector<Signal> signals;
+
+    Buffer impulse(x_sampleRate, 0.0f);
+    impulse[0] = 1.0f;
+    signals.push_back({"impulse", impulse});
+
+    size_t sweepLength = 2 * x_sampleRate;
+    Buffer sweep(sweepLength);
+    double startHz = 20.0;
+    double endHz = 20000.0;
+    double rate = std::log(endHz / startHz);
+    double duration = static_cast<double>(sweepLength) / x_sampleRate;
+    for (size_t i = 0; i < sweepLength; i++)
+    {
+        double t = static_cast<double>(i) / x_sampleRate;
+        double phase = 2.0 * M_PI * startHz * duration / rate * (std::exp(t * rate / duration) - 1.0);
+        sweep[i] = 0.5f * static_cast<float>(std::sin(phase));
+    }
+
+    signals.push_back({"sweep", sweep});
+
+    Buffer noise(x_sampleRate);
+    uint32_t seed = 0x46524F47;
+    for (size_t i = 0; i < noise.size(); i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        noise[i] = (static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f) * 0.5f;
+    }
+
+    signals.push_back({"noise", noise});
+    return signals;
+}
+
+struct GoldenCase
+{
+    const char* m_name;
+    std::function<Buffer(const Buffer&)> m_render;
+};
+
+template<typename Block, typename SetupFn>
+static Buffer RenderBlock(const Buffer& input, SetupFn setup)
+{
+    std::unique_ptr<Block> block(new Block());
+    setup(block.get());
+    Buffer output(input.size());
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        output[i] = block->Process(input[i]);
+    }
+
+    return output;
+}
+
+template<typename T, typename SetupFn>
+static Buffer RenderApp(const Buffer& input, SetupFn setup)
+{
+    HostApp<T> app;
+    setup(&app);
+    Buffer silence(input.size(), 0.0f);
+    Buffer left(input.size());
+    Buffer right(input.size());
+    app.Render(input.data(), silence.data(), left.data(), right.data(), input.size());
+    return left;
+}
+
+// A one-track MIDI file at 96 ticks per beat and 120bpm: a beat of clock,
+// notes on the beats, and CCs on GAIN (page 1, slot 0) and DELF (page 0,
+// slot 0), partly in running status.
+//
+static std::vector<uint8_t> MakeMidiFile()
+{
+    std::vector<uint8_t> track =
+    {
+        0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+        0x00, 0xB0, 24, 90,
+        0x00, 0x90, 60, 100,
+    };
+
+    for (int i = 0; i < 24; i++)
+    {
+        track.insert(track.end(), {0x04, 0xF8});
+    }
+
+    const uint8_t rest[] =
+    {
+        0x00, 0x80, 60, 0,
+        0x00, 0xB0, 16, 20,
+        0x18, 24, 110,
+        0x30, 0x90, 64, 90,
+        0x30, 64, 0,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+
+    track.insert(track.end(), rest, rest + sizeof(rest));
+
+    std::vector<uint8_t> file = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k'};
+    uint32_t length = track.size();
+    file.insert(file.end(), {static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)});
+    file.insert(file.end(), track.begin(), track.end());
+    return file;
+}
+
+// Decaying noise a little over the convolver's head levels, so all three run.
+//
+static Buffer MakeImpulseResponse()
+{
+    Buffer ir(4000);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < ir.size(); i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        float noise = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+        ir[i] = noise * std::exp(-static_cast<float>(i) / 800.0f);
+    }
+
+    return ir;
+}
+
+// A WAV held in memory, read the way the SD card is, for Convolver::Load.
+//
+struct MemorySource
+{
+    std::vector<uint8_t> m_data;
+    size_t m_pos;
+
+    MemorySource(const Buffer& samples)
+        : m_data(WavFormat::x_headerSize + samples.size() * sizeof(float))
+        , m_pos(0)
+    {
+        WavFormat format;
+        format.m_dataSize = samples.size() * sizeof(float);
+        format.WriteHeader(m_data.data());
+        memcpy(m_data.data() + WavFormat::x_headerSize, samples.data(), format.m_dataSize);
+    }
+
+    bool Read(void* dst, size_t size)
+    {
+        if (m_data.size() - m_pos < size)
+        {
+            return false;
+        }
+
+        memcpy(dst, m_data.data() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    void Skip(size_t size)
+    {
+        m_pos += std::min(size, m_data.size() - m_pos);
+    }
+};
+
+template<typename SetupFn>
+static Buffer RenderConvolver(const Buffer& input, SetupFn setup)
+{
+    std::unique_ptr<Convolver> convolver(new Convolver());
+    setup(convolver.get());
+    convolver->SetMix(0.7f);
+
+    Buffer output(input.size());
+    for (size_t i = 0; i < input.size(); i += 48)
+    {
+        size_t size = std::min<size_t>(48, input.size() - i);
+        convolver->ProcessBlock(input.data() + i, output.data() + i, size);
+    }
+
+    return output;
+}
+
+static std::vector<GoldenCase> MakeCases()
+{
+    std::vector<GoldenCase> cases;
+
+    cases.push_back({"comb", [](const Buffer& in)
+    {
+        return RenderBlock<Comb>(in, [](Comb* comb)
+        {
+            comb->m_delaySamples = 113;
+            comb->SetFeedback(0.7f);
+            comb->SetCutoffAlpha(0.5f);
+        });
+    }});
+
+    cases.push_back({"pure_delay", [](const Buffer& in)
+    {
+        return RenderBlock<PureDelay>(in, [](PureDelay* delay)
+        {
+            delay->SetDelaySamples(1.0f / 123.5f);
+        });
+    }});
+
+    cases.push_back({"resonant_bump", [](const Buffer& in)
+    {
+        return RenderBlock<ResonantBump>(in, [](ResonantBump* bump)
+        {
+            bump->SetFreq(1000.0f / x_sampleRate);
+            bump->SetHeight(4.0f);
+            bump->SetWidth(2.0f);
+        });
+    }});
+
+    cases.push_back({"eq", [](const Buffer& in)
+    {
+        return RenderBlock<EQ>(in, [](EQ* eq)
+        {
+            eq->SetLowGain(2.0f);
+            eq->SetLowMidGain(0.5f);
+            eq->SetHighMidGain(1.5f);
+            eq->SetHighGain(0.7f);
+        });
+    }});
+
+    cases.push_back({"polynomial_drive", [](const Buffer& in)
+    {
+        return RenderBlock<PolynomialDrive>(in, [](PolynomialDrive* drive)
+        {
+            drive->SetGain(0.5f);
+            drive->SetCoefs(0.3f);
+        });
+    }});
+
+    cases.push_back({"digital_reorganizer", [](const Buffer& in)
+    {
+        return RenderBlock<DigitalReorganizer>(in, [](DigitalReorganizer* reorganizer)
+        {
+            reorganizer->SetFlip(0.3f);
+            reorganizer->SetHash(0.5f);
+        });
+    }});
+
+    cases.push_back({"frog_block", [](const Buffer& in)
+    {
+        std::unique_ptr<FrogBlock> frogBlock(new FrogBlock());
+        frogBlock->m_polynomialDrive.SetGain(0.4f);
+        frogBlock->m_polynomialDrive.SetCoefs(0.2f);
+        frogBlock->m_sampleRateReducer1.SetFreq(0.5f);
+        frogBlock->m_sampleRateReducer2.SetFreq(0.8f);
+        frogBlock->m_digitalReorganizer.SetFlip(0.1f);
+        frogBlock->m_digitalReorganizer.SetHash(0.25f);
+        frogBlock->m_fuzz = 0.3f;
+
+        Buffer output(in.size());
+        frogBlock->ProcessBlock(in.data(), output.data(), in.size());
+        return output;
+    }});
+
+    cases.push_back({"frog_block_antiderivative", [](const Buffer& in)
+    {
+        std::unique_ptr<FrogBlock> frogBlock(new FrogBlock());
+        frogBlock->m_polynomialDrive.SetGain(0.4f);
+        frogBlock->m_polynomialDrive.SetCoefs(0.2f);
+        frogBlock->SetAntiAlias(1.0f);
+        frogBlock->m_fuzz = 0.3f;
+
+        Buffer output(in.size());
+        frogBlock->ProcessBlock(in.data(), output.data(), in.size());
+        return output;
+    }});
+
+    cases.push_back({"convolver", [](const Buffer& in)
+    {
+        return RenderConvolver(in, [](Convolver* convolver)
+        {
+            Buffer ir = MakeImpulseResponse();
+            convolver->SetImpulse(ir.data(), ir.size());
+        });
+    }});
+
+    // The same IR through the WAV reader, as it comes off the SD card.
+    //
+    cases.push_back({"convolver_load", [](const Buffer& in)
+    {
+        return RenderConvolver(in, [](Convolver* convolver)
+        {
+            MemorySource source(MakeImpulseResponse());
+            convolver->Load(&source);
+        });
+    }});
+
+    cases.push_back({"froggers_default", [](const Buffer& in)
+    {
+        return RenderApp<Froggers>(in, [](HostApp<Froggers>*)
+        {
+        });
+    }});
+
+    cases.push_back({"froggers_patch", [](const Buffer& in)
+    {
+        return RenderApp<Froggers>(in, [](HostApp<Froggers>* app)
+        {
+            const float filter[] = {0.3f, 0.6f, 0.3f, 0.5f, 0.4f, 0.6f, 0.6f};
+            const float drive[] = {0.3f, 0.3f, 0.2f, 0.1f, 0.3f, 0.4f, 0.2f};
+            for (uint8_t i = 0; i < 7; i++)
+            {
+                app->SetParam(Froggers::x_filterPage, i, filter[i]);
+                app->SetParam(Froggers::x_drivePage, i, drive[i]);
+            }
+        });
+    }});
+
+    cases.push_back({"froggers_midi", [](const Buffer& in)
+    {
+        return RenderApp<Froggers>(in, [](HostApp<Froggers>* app)
+        {
+            // Everything is queued up front; each message waits for its
+            // frame.
+            //
+            std::vector<uint8_t> data = MakeMidiFile();
+            MidiFile file;
+            if (!file.Parse(data.data(), data.size(), x_sampleRate))
+            {
+                fprintf(stderr, "froggers_midi: %s\n", file.m_error.c_str());
+                return;
+            }
+
+            for (const MidiFile::Message& message : file.m_messages)
+            {
+                app->SendMidi(message.m_bytes, message.m_size, message.m_frame);
+            }
+        });
+    }});
+
+    cases.push_back({"poggers", [](const Buffer& in)
+    {
+        return RenderApp<Poggers>(in, [](HostApp<Poggers>*)
+        {
+        });
+    }});
+
+    return cases;
+}
+
+// Properties that hold to rounding error rather than against a stored render,
+// checked alongside the references. Each returns its worst error.
+//
+struct GoldenInvariant
+{
+    const char* m_name;
+    float m_tolerance;
+    std::function<float()> m_error;
+};
+
+static std::vector<GoldenInvariant> MakeInvariants()
+{
+    std::vector<GoldenInvariant> invariants;
+
+    // The drive's mean over a zero-length step is the drive itself.
+    //
+    invariants.push_back({"adaa_matches_drive", 1e-4f, []()
+    {
+        float worst = 0.0f;
+        for (float shape : {0.0f, 0.2f, 0.5f, 0.9f})
+        {
+            PolynomialDrive drive;
+            drive.SetGain(0.4f);
+            drive.SetCoefs(shape);
+            float coefs[PolynomialDrive::x_numCoefs];
+            for (size_t i = 0; i < x_sampleRate; i++)
+            {
+                drive.NextCoefs(coefs);
+            }
+
+            for (float x = -1.5f; x <= 1.5f; x += 1.0f / 64)
+            {
+                float expected = drive.Process(x);
+                float error = std::abs(PolynomialDrive::Antiderivative(coefs, x, x) - expected);
+                worst = std::max(worst, error / std::max(1.0f, std::abs(expected)));
+            }
+        }
+
+        return worst;
+    }});
+
+    // Silence after an impulse decays to silence, or the silence gate could
+    // never sleep in ADAA mode.
+    //
+    invariants.push_back({"adaa_silence", 1e-6f, []()
+    {
+        std::unique_ptr<FrogBlock> frogBlock(new FrogBlock());
+        frogBlock->m_polynomialDrive.SetGain(0.4f);
+        frogBlock->m_polynomialDrive.SetCoefs(0.2f);
+        frogBlock->SetAntiAlias(1.0f);
+        frogBlock->m_fuzz = 0.3f;
+
+        Buffer input(x_sampleRate, 0.0f);
+        input[0] = 1.0f;
+        Buffer output(input.size());
+        frogBlock->ProcessBlock(input.data(), output.data(), input.size());
+
+        float worst = 0.0f;
+        for (size_t i = input.size() / 2; i < input.size(); i++)
+        {
+            worst = std::max(worst, std::abs(output[i]));
+        }
+
+        return worst;
+    }});
+
+    // The Q15 sample-and-holds against the library's float SampleRateReducer,
+    // in LSBs, across a sweep of SRR1 and SRR2 settings. The reference gets
+    // the same per-sample ramp FrogBlock gives the Q15 stages at each change.
+    //
+    invariants.push_back({"srr_matches_float", 1.0f, []()
+    {
+        static constexpr size_t x_blockSize = FrogBlock::x_maxBlockSize;
+        static constexpr size_t x_blocksPerSetting = 20;
+        SampleRateReducerQ15 reducer1;
+        SampleRateReducerQ15 reducer2;
+        SampleRateReducer reference1;
+        SampleRateReducer reference2;
+        float freq1 = reducer1.m_freq;
+        float freq2 = reducer2.m_freq;
+        float input[x_blockSize];
+        int16_t digital[x_blockSize];
+        uint32_t seed = 1;
+        float worst = 0.0f;
+        for (float knob1 = 0.0f; knob1 <= 1.0f; knob1 += 0.125f)
+        {
+            for (float knob2 = 0.0f; knob2 <= 1.0f; knob2 += 0.125f)
+            {
+                float target1 = Froggers::SampleRateReducerTable::Lookup(knob1);
+                float target2 = Froggers::SampleRateReducerTable::Lookup(knob2);
+                for (size_t block = 0; block < x_blocksPerSetting; block++)
+                {
+                    for (float& sample : input)
+                    {
+                        seed = seed * 1664525u + 1013904223u;
+                        sample = (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f) * 1.8f;
+                    }
+
+                    reducer1.SetFreq(target1);
+                    reducer2.SetFreq(target2);
+                    Q15::FromFloatBlock(input, digital, x_blockSize);
+                    reducer1.ProcessBlock(digital, x_blockSize);
+                    reducer2.ProcessBlock(digital, x_blockSize);
+
+                    float step1 = (target1 - freq1) / x_blockSize;
+                    float step2 = (target2 - freq2) / x_blockSize;
+                    for (size_t i = 0; i < x_blockSize; i++)
+                    {
+                        freq1 += step1;
+                        freq2 += step2;
+                        reference1.SetFreq(freq1);
+                        reference2.SetFreq(freq2);
+                        float expected = reference2.Process(reference1.Process(input[i]));
+                        worst = std::max(worst, std::abs(Q15::ToFloat(digital[i]) - expected) * 32768.0f);
+                    }
+
+                    freq1 = target1;
+                    freq2 = target2;
+                }
+            }
+        }
+
+        return worst;
+    }});
+
+    // Record a loop, stop it and let the pipeline fall asleep on silence.
+    // Playing the loop again must wake it with no input to do so. The error
+    // is 1 if the gate never slept or the loop stayed silent.
+    //
+    invariants.push_back({"silence_gate_wakes_for_looper", 0.0f, []()
+    {
+        HostApp<Froggers> app;
+        size_t blockSize = HostApp<Froggers>::x_blockSize;
+        Buffer noise(blockSize);
+        Buffer silence(blockSize, 0.0f);
+        Buffer left(blockSize);
+        Buffer right(blockSize);
+        uint32_t seed = 1;
+        auto run = [&](size_t numBlocks, bool loud)
+        {
+            float peak = 0.0f;
+            for (size_t block = 0; block < numBlocks; block++)
+            {
+                for (float& sample : noise)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    sample = (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f) * 0.5f;
+                }
+
+                const float* in = loud ? noise.data() : silence.data();
+                app.ProcessBlock(in, in, left.data(), right.data(), blockSize);
+                for (float sample : left)
+                {
+                    peak = std::max(peak, std::abs(sample));
+                }
+            }
+
+            return peak;
+        };
+
+        app.PressButton(1);
+        run(x_sampleRate / blockSize / 4, true);
+        app.PressButton(1);
+        app.PressButton(3);
+        run(10 * x_sampleRate / blockSize, false);
+        bool slept = app.m_app->m_silenceGate.m_asleep;
+
+        app.PressButton(1);
+        float peak = run(x_sampleRate / blockSize / 4, false);
+        return slept && SilenceGate::x_threshold < peak ? 0.0f : 1.0f;
+    }});
+
+    return invariants;
+}
+
+static std::string ReferencePath(const std::string& dir, const GoldenCase& goldenCase, const Signal& signal)
+{
+    return dir + "/" + goldenCase.m_name + "_" + signal.m_name + ".wav";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s update <dir> | check <dir> [tolerance] | list\n", argv[0]);
+        return 2;
+    }
+
+    std::string mode = argv[1];
+    std::vector<GoldenCase> cases = MakeCases();
+    if (mode == "list")
+    {
+        for (const GoldenCase& goldenCase : cases)
+        {
+            printf("%s\n", goldenCase.m_name);
+        }
+
+        return 0;
+    }
+
+    if (argc < 3 || (mode != "update" && mode != "check"))
+    {
+        fprintf(stderr, "usage: %s update <dir> | check <dir> [tolerance] | list\n", argv[0]);
+        return 2;
+    }
+
+    std::string dir = argv[2];
+    float tolerance = argc > 3 ? static_cast<float>(atof(argv[3])) : 1e-4f;
+    std::vector<Signal> signals = MakeSignals();
+    size_t numFailed = 0;
+
+    for (const GoldenCase& goldenCase : cases)
+    {
+        for (const Signal& signal : signals)
+        {
+            std::string path = ReferencePath(dir, goldenCase, signal);
+            Buffer output = goldenCase.m_render(signal.m_samples);
+
+            if (mode == "update")
+            {
+                WavFile wav;
+                wav.m_sampleRate = x_sampleRate;
+                wav.m_channels.push_back(output);
+                if (!wav.Write(path))
+                {
+                    fprintf(stderr, "FAIL %s: cannot write\n", path.c_str());
+                    numFailed++;
+                }
+
+                continue;
+            }
+
+            WavFile reference;
+            if (!reference.Read(path) || reference.m_channels.size() != 1 || reference.NumFrames() != output.size())
+            {
+                printf("FAIL %s: missing or wrong shape\n", path.c_str());
+                numFailed++;
+                continue;
+            }
+
+            float maxError = 0.0f;
+            size_t maxErrorIndex = 0;
+            bool nonFinite = false;
+            for (size_t i = 0; i < output.size(); i++)
+            {
+                if (!std::isfinite(output[i]))
+                {
+                    nonFinite = true;
+                }
+
+                float error = std::abs(output[i] - reference.m_channels[0][i]);
+                if (maxError < error)
+                {
+                    maxError = error;
+                    maxErrorIndex = i;
+                }
+            }
+
+            bool passed = !nonFinite && maxError <= tolerance;
+            printf("%s %s_%s: max error %g at sample %zu%s\n",
+                   passed ? "ok  " : "FAIL",
+                   goldenCase.m_name,
+                   signal.m_name,
+                   maxError,
+                   maxErrorIndex,
+                   nonFinite ? " (non-finite output)" : "");
+            if (!passed)
+            {
+                numFailed++;
+            }
+        }
+    }
+
+    if (mode == "check")
+    {
+        for (const GoldenInvariant& invariant : MakeInvariants())
+        {
+            float error = invariant.m_error();
+            bool passed = error <= invariant.m_tolerance;
+            printf("%s %s: max error %g\n", passed ? "ok  " : "FAIL", invariant.m_name, error);
+            if (!passed)
+            {
+                numFailed++;
+            }
+        }
+    }
+
+    if (numFailed)
+    {
+        printf("%zu case(s) failed\n", numFailed);
+    }
+
+    return numFailed ? 1 : 0;
+}
\ No newline at end of file
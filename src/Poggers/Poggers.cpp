@@ -1,9 +1,11 @@
 #include "../common/Include.hpp"
 #include "Poggers.hpp"
 
+static_assert(sizeof(App<Poggers>) <= App<Poggers>::x_maxSize, "Poggers must fit in AXI SRAM");
+
 int main(void)
 {
-    App<Poggers> app;
+    static App<Poggers> app;
     app.LetsFuckingDoThisShit();
     return 0;
 }
\ No newline at end of file
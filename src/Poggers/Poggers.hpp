@@ -42,16 +42,32 @@ struct Poggers
         }
     }
 
-    void Process(AudioHandle::InputBuffer& in, AudioHandle::OutputBuffer& out, size_t size)
+    void ConfigPipeline(AudioPipeline* pipeline)
+    {
+        pipeline->AddStage<Poggers, &Poggers::ProcessBlock>(0, this, AudioPipeline::Mode::InPlace);
+        pipeline->SetEmptyMode(1, AudioPipeline::EmptyMode::Silence);
+    }
+
+    void BeginBlock(size_t size)
+    {
+    }
+
+    void ProcessBlock(const float* input, float* output, size_t size)
     {
-        memset(out[0], 0, size * sizeof(float));
         for (size_t i = 0; i < size; i++)
         {
-            out[0][i] = Process(in[0][i]);
-            out[1][i] = 0;                 
+            output[i] = Process(input[i]);
         }
     }
 
+    void GateCallback()
+    {
+    }
+
+    void ButtonCallback(int button)
+    {
+    }
+
     float Process(float input)
     {    
         m_buffer.m_table[m_index] = input;
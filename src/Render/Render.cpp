@@ -0,0 +1,271 @@
+#include "../common/Include.hpp"
+#include "../Froggers/Froggers.hpp"
+#include "../Poggers/Poggers.hpp"
+#include "Automation.hpp"
+#include "HostApp.hpp"
+#include "WavFile.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Offline renderer. Runs input WAVs through an app with an optional
+// automation file and MIDI file, faster than real time and one file per
+// worker thread:
+//
+//   Render [-a froggers|poggers] [-p automation.txt] [-m song.mid] [-o outdir] [-j jobs] [-t tail] [-T trace.txt] in.wav...
+//
+// Each input writes <outdir>/<name>.<app>.wav as stereo 32-bit float. Mono
+// inputs feed both channels. The tail (seconds of silence appended to the
+// input) lets delays and combs ring out. -T writes the trace to a file, or
+// to stdout for "-"; timestamps are wall clock, and records from parallel
+// jobs interleave.
+//
+
+// Audio rendered by all workers, for the per-second counter rates.
+//
+static std::atomic<uint64_t> s_renderedFrames(0);
+
+struct RenderOptions
+{
+    std::string m_app;
+    std::string m_automationPath;
+    std::string m_midiPath;
+    std::string m_outDir;
+    std::string m_tracePath;
+    size_t m_numJobs;
+    float m_tailSeconds;
+    Automation m_automation;
+
+    RenderOptions()
+        : m_app("froggers")
+        , m_outDir(".")
+        , m_numJobs(std::max(1u, std::thread::hardware_concurrency()))
+        , m_tailSeconds(0.0f)
+    {
+    }
+};
+
+template<typename T>
+static void RenderApp(const RenderOptions& options, const WavFile& input, WavFile* output)
+{
+    HostApp<T> app;
+    size_t tail = static_cast<size_t>(options.m_tailSeconds * input.m_sampleRate);
+    size_t numFrames = input.NumFrames() + tail;
+
+    std::vector<float> left(input.m_channels[0]);
+    std::vector<float> right(input.m_channels.size() > 1 ? input.m_channels[1] : input.m_channels[0]);
+    left.resize(numFrames, 0.0f);
+    right.resize(numFrames, 0.0f);
+
+    output->m_sampleRate = input.m_sampleRate;
+    output->m_channels.assign(2, std::vector<float>(numFrames));
+    options.m_automation.Render(&app, left.data(), right.data(), output->m_channels[0].data(), output->m_channels[1].data(), numFrames);
+}
+
+static std::string OutputPath(const RenderOptions& options, const std::string& inputPath)
+{
+    size_t slash = inputPath.find_last_of('/');
+    std::string name = slash == std::string::npos ? inputPath : inputPath.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos)
+    {
+        name = name.substr(0, dot);
+    }
+
+    return options.m_outDir + "/" + name + "." + options.m_app + ".wav";
+}
+
+static bool RenderFile(const RenderOptions& options, const std::string& inputPath)
+{
+    WavFile input;
+    if (!input.Read(inputPath) || input.NumFrames() == 0)
+    {
+        fprintf(stderr, "%s: cannot read\n", inputPath.c_str());
+        return false;
+    }
+
+    if (input.m_sampleRate != 48000)
+    {
+        fprintf(stderr, "%s: warning: %u Hz input rendered as 48000 Hz\n", inputPath.c_str(), input.m_sampleRate);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    WavFile output;
+    if (options.m_app == "froggers")
+    {
+        RenderApp<Froggers>(options, input, &output);
+    }
+    else
+    {
+        RenderApp<Poggers>(options, input, &output);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::string outputPath = OutputPath(options, inputPath);
+    if (!output.Write(outputPath))
+    {
+        fprintf(stderr, "%s: cannot write\n", outputPath.c_str());
+        return false;
+    }
+
+    s_renderedFrames += output.NumFrames();
+    double seconds = static_cast<double>(output.NumFrames()) / output.m_sampleRate;
+    printf("%s -> %s (%.1fs audio, %.1fx real time)\n",
+           inputPath.c_str(),
+           outputPath.c_str(),
+           seconds,
+           seconds / std::max(elapsed.count(), 1e-9));
+    return true;
+}
+
+static int Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [-a froggers|poggers] [-p automation.txt] [-m song.mid] [-o outdir] [-j jobs] [-t tail] [-T trace.txt] in.wav...\n", argv0);
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    RenderOptions options;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-a") == 0 && hasValue)
+        {
+            options.m_app = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0 && hasValue)
+        {
+            options.m_automationPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-m") == 0 && hasValue)
+        {
+            options.m_midiPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && hasValue)
+        {
+            options.m_outDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-j") == 0 && hasValue)
+        {
+            options.m_numJobs = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-t") == 0 && hasValue)
+        {
+            options.m_tailSeconds = std::max(0.0f, static_cast<float>(atof(argv[++i])));
+        }
+        else if (strcmp(argv[i], "-T") == 0 && hasValue)
+        {
+            options.m_tracePath = argv[++i];
+        }
+        else if (argv[i][0] == '-')
+        {
+            return Usage(argv[0]);
+        }
+        else
+        {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty() || (options.m_app != "froggers" && options.m_app != "poggers"))
+    {
+        return Usage(argv[0]);
+    }
+
+    // The automation is timed in seconds, so it is converted at 48kHz, the
+    // rate the apps are built for.
+    //
+    if (!options.m_automationPath.empty() && !options.m_automation.Read(options.m_automationPath, 48000))
+    {
+        fprintf(stderr, "%s\n", options.m_automation.m_error.c_str());
+        return 1;
+    }
+
+    if (!options.m_midiPath.empty() && !options.m_automation.ReadMidi(options.m_midiPath, 48000))
+    {
+        fprintf(stderr, "%s\n", options.m_automation.m_error.c_str());
+        return 1;
+    }
+
+    FILE* traceFile = nullptr;
+    if (options.m_tracePath == "-")
+    {
+        traceFile = stdout;
+    }
+    else if (!options.m_tracePath.empty())
+    {
+        traceFile = fopen(options.m_tracePath.c_str(), "w");
+        if (!traceFile)
+        {
+            fprintf(stderr, "%s: cannot write\n", options.m_tracePath.c_str());
+            return 1;
+        }
+    }
+
+    // Workers pull files off a shared index. Each render owns its own app, so
+    // nothing is shared between them but the read-only options.
+    //
+    std::atomic<size_t> nextInput(0);
+    std::atomic<size_t> numFailed(0);
+    std::atomic<size_t> numDone(0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(options.m_numJobs, inputs.size()); i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t j = nextInput++; j < inputs.size(); j = nextInput++)
+            {
+                if (!RenderFile(options, inputs[j]))
+                {
+                    numFailed++;
+                }
+            }
+
+            numDone++;
+        });
+    }
+
+    // The main thread stands in for the firmware's main loop and drains the
+    // trace while the workers render.
+    //
+    while (traceFile && numDone < workers.size())
+    {
+        Trace::Drain(Trace::PrintToFile, traceFile);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (traceFile)
+    {
+        Trace::Drain(Trace::PrintToFile, traceFile);
+        if (traceFile != stdout)
+        {
+            fclose(traceFile);
+        }
+    }
+
+    double renderedSeconds = std::max(static_cast<double>(s_renderedFrames) / 48000, 1e-9);
+    for (size_t i = 0; i < Instrumentation::x_numCounters; i++)
+    {
+        Instrumentation::Counter counter = static_cast<Instrumentation::Counter>(i);
+        if (Instrumentation::Get(counter))
+        {
+            printf("%s: %u (%.1f per second of audio)\n", Instrumentation::GetName(counter), Instrumentation::Get(counter), Instrumentation::Get(counter) / renderedSeconds);
+        }
+    }
+
+    return numFailed ? 1 : 0;
+}
\ No newline at end of file
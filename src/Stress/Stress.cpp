@@ -0,0 +1,612 @@
+#include "../common/Include.hpp"
+#include "../Froggers/Froggers.hpp"
+#include "../Poggers/Poggers.hpp"
+#include "HostApp.hpp"
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Worst-case search over an app's controls, so a pathological patch turns up
+// here and not on stage after a RandomizeAllPages. Each candidate patch (every
+// knob including FUEG, mod routings, the CV inputs and a few button presses)
+// is rendered on a fresh app over noise with a clock on the gate, timing every
+// callback:
+//
+//   Stress [-a froggers|poggers] [-n random] [-c climb] [-l seconds] [-s seed] [-z] [-o outdir]
+//
+// The search draws -n random patches, half here and half from the app's own
+// RandomizeAllPages and RandomizeAllPagesMod, then hill-climbs from the
+// slowest for -c steps, nudging a few controls at a time and keeping a change
+// when the cost goes up by more than x_minGain, measured again to be sure.
+//
+// Cost is the 99th percentile block time. That ignores the odd block the OS
+// steals but keeps anything a patch does every hundred blocks. Host times only
+// rank patches, so the worst is also given as a multiple of the default
+// patch, which carries over to the target better than microseconds do.
+//
+// A patch that puts NaN, inf or subnormals on the output, peaks past
+// x_blowupPeak or trips a non-finite reset is a fault, reported as found
+// whatever its cost. -z leaves flush to zero off, so patches that fill the
+// feedback paths with subnormals also show up in the timing.
+//
+// Patches are written as automation files, <outdir>/stress.<app>.txt for the
+// worst and stress.<app>.fault<n>.txt for faults, with the input as
+// stress_input.wav, so Render -p replays them.
+//
+
+static constexpr uint32_t x_sampleRate = 48000;
+static constexpr double x_warmupSeconds = 0.25;
+static constexpr double x_clockSeconds = 0.5;
+static constexpr size_t x_numButtons = 4;
+static constexpr size_t x_maxPresses = 4;
+static constexpr size_t x_maxFaultFiles = 8;
+static constexpr size_t x_remeasure = 3;
+static constexpr float x_blowupPeak = 8.0f;
+static constexpr double x_minGain = 0.03;
+
+struct StressOptions
+{
+    std::string m_app;
+    std::string m_outDir;
+    size_t m_numRandom;
+    size_t m_numClimb;
+    double m_seconds;
+    uint32_t m_seed;
+    bool m_subnormals;
+
+    StressOptions()
+        : m_app("froggers")
+        , m_outDir(".")
+        , m_numRandom(64)
+        , m_numClimb(256)
+        , m_seconds(1.0)
+        , m_seed(1)
+        , m_subnormals(false)
+    {
+    }
+};
+
+// A knob that exists: one of the app's InitParam'd slots.
+//
+struct Control
+{
+    uint8_t m_page;
+    uint8_t m_slot;
+};
+
+struct Patch
+{
+    struct Press
+    {
+        size_t m_block;
+        uint8_t m_button;
+    };
+
+    std::vector<float> m_knob;
+    std::vector<uint8_t> m_modSource;
+    std::vector<float> m_modAmount;
+    float m_cv[daisy::DaisyField::x_numCvs];
+    std::vector<Press> m_presses;
+};
+
+struct Result
+{
+    double m_p99Us;
+    double m_maxUs;
+    double m_meanUs;
+    size_t m_nonFinite;
+    size_t m_subnormal;
+    uint32_t m_resets;
+    float m_peak;
+
+    bool IsFault() const
+    {
+        return m_nonFinite || m_subnormal || m_resets || !(m_peak <= x_blowupPeak);
+    }
+};
+
+// Noise at half scale, independent per channel, from a fixed-seed LCG so runs
+// with the same seed hear the same input. The gate is high for the first
+// block of every x_clockSeconds.
+//
+struct Stimulus
+{
+    std::vector<float> m_left;
+    std::vector<float> m_right;
+    size_t m_numBlocks;
+    size_t m_warmupBlocks;
+    size_t m_clockBlocks;
+
+    Stimulus(double seconds)
+    {
+        size_t blockSize = HostApp<Froggers>::x_blockSize;
+        m_warmupBlocks = static_cast<size_t>(x_warmupSeconds * x_sampleRate) / blockSize;
+        m_numBlocks = m_warmupBlocks + std::max<size_t>(1, static_cast<size_t>(seconds * x_sampleRate) / blockSize);
+        m_clockBlocks = static_cast<size_t>(x_clockSeconds * x_sampleRate) / blockSize;
+
+        m_left.resize(m_numBlocks * blockSize);
+        m_right.resize(m_numBlocks * blockSize);
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < m_left.size(); i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            m_left[i] = (static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f) * 0.5f;
+            seed = seed * 1664525 + 1013904223;
+            m_right[i] = (static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f) * 0.5f;
+        }
+    }
+
+    bool Gate(size_t block) const
+    {
+        return block % m_clockBlocks == 0;
+    }
+
+    double BlockSeconds(size_t block) const
+    {
+        return static_cast<double>(block * HostApp<Froggers>::x_blockSize) / x_sampleRate;
+    }
+};
+
+template<typename T>
+struct Search
+{
+    const StressOptions& m_options;
+    Stimulus m_stimulus;
+    std::vector<Control> m_controls;
+    std::mt19937 m_rng;
+    size_t m_numEvaluations;
+    size_t m_numFaults;
+
+    Search(const StressOptions& options)
+        : m_options(options)
+        , m_stimulus(options.m_seconds)
+        , m_rng(options.m_seed)
+        , m_numEvaluations(0)
+        , m_numFaults(0)
+    {
+        HostApp<T> app;
+        PageManager& pageManager = app.GetPageManager();
+        for (uint8_t page = 0; page < pageManager.m_numPages; page++)
+        {
+            for (uint8_t slot = 0; slot < Parameter::x_numParameters; slot++)
+            {
+                if (!pageManager.m_pages[page].m_parameters[slot].IsEmpty())
+                {
+                    m_controls.push_back(Control{page, slot});
+                }
+            }
+        }
+    }
+
+    float Uniform()
+    {
+        return std::uniform_real_distribution<float>(0.0f, 1.0f)(m_rng);
+    }
+
+    size_t Below(size_t n)
+    {
+        return std::uniform_int_distribution<size_t>(0, n - 1)(m_rng);
+    }
+
+    Patch::Press RandomPress()
+    {
+        return Patch::Press{m_stimulus.m_warmupBlocks + Below(m_stimulus.m_numBlocks - m_stimulus.m_warmupBlocks), static_cast<uint8_t>(Below(x_numButtons))};
+    }
+
+    // What a freshly configured app holds, CVs at zero and nothing pressed.
+    //
+    Patch Capture(HostApp<T>* app)
+    {
+        Patch patch;
+        for (const Control& control : m_controls)
+        {
+            const Parameter& parameter = app->GetPageManager().m_pages[control.m_page].m_parameters[control.m_slot];
+            patch.m_knob.push_back(parameter.m_knobValue);
+            patch.m_modSource.push_back(parameter.m_modIndex);
+            patch.m_modAmount.push_back(parameter.m_modAmount);
+        }
+
+        std::fill(std::begin(patch.m_cv), std::end(patch.m_cv), 0.0f);
+        return patch;
+    }
+
+    Patch Default()
+    {
+        HostApp<T> app;
+        return Capture(&app);
+    }
+
+    // Half the draws go through the app's own randomizers, which skip FUEG;
+    // the other half cover every knob, FUEG included, with the same odds of a
+    // mod routing.
+    //
+    Patch Random()
+    {
+        HostApp<T> app;
+        bool own = Uniform() < 0.5f;
+        if (own)
+        {
+            app.GetPageManager().RandomizeAllPages();
+            app.GetPageManager().RandomizeAllPagesMod();
+        }
+
+        Patch patch = Capture(&app);
+        if (!own)
+        {
+            for (size_t i = 0; i < m_controls.size(); i++)
+            {
+                patch.m_knob[i] = Uniform();
+                bool routed = Uniform() < 0.5f;
+                patch.m_modSource[i] = routed ? static_cast<uint8_t>(Below(ModMgr::x_numMods)) : 255;
+                patch.m_modAmount[i] = routed ? Uniform() : 0.0f;
+            }
+        }
+
+        for (float& cv : patch.m_cv)
+        {
+            cv = Uniform();
+        }
+
+        size_t numPresses = Below(x_maxPresses + 1);
+        for (size_t i = 0; i < numPresses; i++)
+        {
+            patch.m_presses.push_back(RandomPress());
+        }
+
+        return patch;
+    }
+
+    // One to three changes: mostly knob nudges, sometimes a new mod routing,
+    // CV value or button press.
+    //
+    Patch Mutate(const Patch& patch)
+    {
+        Patch mutated = patch;
+        size_t numChanges = 1 + Below(3);
+        for (size_t i = 0; i < numChanges; i++)
+        {
+            size_t control = Below(m_controls.size());
+            float choice = Uniform();
+            if (choice < 0.6f)
+            {
+                float nudge = std::normal_distribution<float>(0.0f, 0.15f)(m_rng);
+                mutated.m_knob[control] = std::min(std::max(mutated.m_knob[control] + nudge, 0.0f), 1.0f);
+            }
+            else if (choice < 0.8f)
+            {
+                size_t source = Below(ModMgr::x_numMods + 1);
+                mutated.m_modSource[control] = source < ModMgr::x_numMods ? static_cast<uint8_t>(source) : 255;
+                mutated.m_modAmount[control] = Uniform();
+            }
+            else if (choice < 0.9f)
+            {
+                mutated.m_cv[Below(daisy::DaisyField::x_numCvs)] = Uniform();
+            }
+            else if (mutated.m_presses.size() < x_maxPresses && (mutated.m_presses.empty() || Uniform() < 0.5f))
+            {
+                mutated.m_presses.push_back(RandomPress());
+            }
+            else
+            {
+                mutated.m_presses.erase(mutated.m_presses.begin() + Below(mutated.m_presses.size()));
+            }
+        }
+
+        return mutated;
+    }
+
+    Result Evaluate(const Patch& patch)
+    {
+        m_numEvaluations++;
+        HostApp<T> app;
+        if (m_options.m_subnormals)
+        {
+            Protection::DisableFlushToZero();
+        }
+
+        for (size_t i = 0; i < m_controls.size(); i++)
+        {
+            app.SetParam(m_controls[i].m_page, m_controls[i].m_slot, patch.m_knob[i]);
+            app.SetMod(m_controls[i].m_page, m_controls[i].m_slot, patch.m_modSource[i], patch.m_modAmount[i]);
+        }
+
+        for (size_t i = 0; i < daisy::DaisyField::x_numCvs; i++)
+        {
+            app.SetCv(i, patch.m_cv[i]);
+        }
+
+        Result result = {};
+        uint32_t resetsBefore = Instrumentation::Get(Instrumentation::Counter::NonFiniteReset);
+        std::vector<double> times;
+        times.reserve(m_stimulus.m_numBlocks - m_stimulus.m_warmupBlocks);
+
+        size_t blockSize = HostApp<T>::x_blockSize;
+        float left[HostApp<T>::x_blockSize];
+        float right[HostApp<T>::x_blockSize];
+        for (size_t block = 0; block < m_stimulus.m_numBlocks; block++)
+        {
+            app.SetGate(m_stimulus.Gate(block));
+            for (const Patch::Press& press : patch.m_presses)
+            {
+                if (press.m_block == block)
+                {
+                    app.PressButton(press.m_button);
+                }
+            }
+
+            size_t offset = block * blockSize;
+            auto start = std::chrono::steady_clock::now();
+            app.ProcessBlock(&m_stimulus.m_left[offset], &m_stimulus.m_right[offset], left, right, blockSize);
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (m_stimulus.m_warmupBlocks <= block)
+            {
+                times.push_back(elapsed.count());
+            }
+
+            for (size_t i = 0; i < blockSize; i++)
+            {
+                for (float sample : {left[i], right[i]})
+                {
+                    int category = std::fpclassify(sample);
+                    result.m_nonFinite += category == FP_NAN || category == FP_INFINITE;
+                    result.m_subnormal += category == FP_SUBNORMAL;
+                    result.m_peak = std::max(result.m_peak, std::abs(sample));
+                }
+            }
+        }
+
+        // A NaN anywhere reads as a blowup.
+        //
+        if (result.m_nonFinite)
+        {
+            result.m_peak = INFINITY;
+        }
+
+        result.m_resets = Instrumentation::Get(Instrumentation::Counter::NonFiniteReset) - resetsBefore;
+        std::sort(times.begin(), times.end());
+        result.m_p99Us = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+        result.m_maxUs = times.back();
+        for (double time : times)
+        {
+            result.m_meanUs += time;
+        }
+
+        result.m_meanUs /= times.size();
+        return result;
+    }
+
+    // The least noisy of a few runs.
+    //
+    Result Remeasure(const Patch& patch)
+    {
+        Result best = Evaluate(patch);
+        for (size_t i = 1; i < x_remeasure; i++)
+        {
+            Result result = Evaluate(patch);
+            if (result.m_p99Us < best.m_p99Us)
+            {
+                best = result;
+            }
+        }
+
+        return best;
+    }
+
+    bool Write(const Patch& patch, const std::string& path)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "%s: cannot write\n", path.c_str());
+            return false;
+        }
+
+        fprintf(file, "# %s stress patch, seed %u; render over stress_input.wav\n", m_options.m_app.c_str(), m_options.m_seed);
+        for (size_t i = 0; i < m_controls.size(); i++)
+        {
+            const Control& control = m_controls[i];
+            fprintf(file, "0 param %u %u %.6f\n", control.m_page, control.m_slot, patch.m_knob[i]);
+            if (patch.m_modSource[i] < ModMgr::x_numMods)
+            {
+                fprintf(file, "0 mod %u %u %u %.6f\n", control.m_page, control.m_slot, patch.m_modSource[i], patch.m_modAmount[i]);
+            }
+        }
+
+        for (size_t i = 0; i < daisy::DaisyField::x_numCvs; i++)
+        {
+            fprintf(file, "0 cv %zu %.6f\n", i, patch.m_cv[i]);
+        }
+
+        for (const Patch::Press& press : patch.m_presses)
+        {
+            fprintf(file, "%.6f button %u\n", m_stimulus.BlockSeconds(press.m_block), press.m_button);
+        }
+
+        for (size_t block = 0; block < m_stimulus.m_numBlocks; block += m_stimulus.m_clockBlocks)
+        {
+            fprintf(file, "%.6f trigger\n", m_stimulus.BlockSeconds(block));
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    std::string PatchPath(const char* suffix) const
+    {
+        return m_options.m_outDir + "/stress." + m_options.m_app + suffix + ".txt";
+    }
+
+    static void Print(const char* label, const Result& result)
+    {
+        printf("%s: p99 %.1fus, max %.1fus, mean %.1fus, peak %.2f",
+               label,
+               result.m_p99Us,
+               result.m_maxUs,
+               result.m_meanUs,
+               result.m_peak);
+        if (result.IsFault())
+        {
+            printf(" [FAULT: %zu non-finite, %zu subnormal, %u resets]", result.m_nonFinite, result.m_subnormal, result.m_resets);
+        }
+
+        printf("\n");
+    }
+
+    // Faults are kept whatever they cost, up to x_maxFaultFiles of them.
+    //
+    void CheckFault(const Patch& patch, const Result& result)
+    {
+        if (!result.IsFault())
+        {
+            return;
+        }
+
+        m_numFaults++;
+        char label[32];
+        snprintf(label, sizeof(label), "fault %zu", m_numFaults);
+        Print(label, result);
+        if (m_numFaults <= x_maxFaultFiles)
+        {
+            snprintf(label, sizeof(label), ".fault%zu", m_numFaults);
+            Write(patch, PatchPath(label));
+        }
+    }
+
+    int Run()
+    {
+        WavFile input;
+        input.m_sampleRate = x_sampleRate;
+        input.m_channels = {m_stimulus.m_left, m_stimulus.m_right};
+        std::string inputPath = m_options.m_outDir + "/stress_input.wav";
+        if (!input.Write(inputPath))
+        {
+            fprintf(stderr, "%s: cannot write\n", inputPath.c_str());
+            return 1;
+        }
+
+        printf("%s: %zu controls, %.2fs per patch\n", m_options.m_app.c_str(), m_controls.size(), m_options.m_seconds);
+        Patch defaultPatch = Default();
+        Result defaultResult = Remeasure(defaultPatch);
+        Print("default", defaultResult);
+        CheckFault(defaultPatch, defaultResult);
+
+        Patch worst = defaultPatch;
+        Result worstResult = defaultResult;
+        for (size_t i = 0; i < m_options.m_numRandom; i++)
+        {
+            Patch patch = Random();
+            Result result = Evaluate(patch);
+            CheckFault(patch, result);
+            if (worstResult.m_p99Us < result.m_p99Us)
+            {
+                worst = patch;
+                worstResult = result;
+                printf("random %zu: ", i);
+                Print("new worst", result);
+            }
+        }
+
+        // Single runs are noisy, and climbing on them would ratchet up on
+        // lucky measurements. Steps compare like with like: a step that looks
+        // better is measured again the same way as the patch it would replace.
+        //
+        worstResult = Remeasure(worst);
+        for (size_t i = 0; i < m_options.m_numClimb; i++)
+        {
+            Patch patch = Mutate(worst);
+            Result result = Evaluate(patch);
+            CheckFault(patch, result);
+            if (worstResult.m_p99Us * (1.0 + x_minGain) < result.m_p99Us)
+            {
+                result = Remeasure(patch);
+                if (worstResult.m_p99Us * (1.0 + x_minGain) < result.m_p99Us)
+                {
+                    worst = patch;
+                    worstResult = result;
+                    printf("climb %zu: ", i);
+                    Print("new worst", result);
+                }
+            }
+        }
+
+        defaultResult = Remeasure(defaultPatch);
+        Print("worst", worstResult);
+        printf("worst/default: %.2fx p99, %.2fx mean over %zu patches\n",
+               worstResult.m_p99Us / std::max(defaultResult.m_p99Us, 1e-9),
+               worstResult.m_meanUs / std::max(defaultResult.m_meanUs, 1e-9),
+               m_numEvaluations);
+        if (m_numFaults)
+        {
+            printf("%zu faulting patches\n", m_numFaults);
+        }
+
+        return Write(worst, PatchPath("")) ? 0 : 1;
+    }
+};
+
+static int Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [-a froggers|poggers] [-n random] [-c climb] [-l seconds] [-s seed] [-z] [-o outdir]\n", argv0);
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    StressOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-a") == 0 && hasValue)
+        {
+            options.m_app = argv[++i];
+        }
+        else if (strcmp(argv[i], "-n") == 0 && hasValue)
+        {
+            options.m_numRandom = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-c") == 0 && hasValue)
+        {
+            options.m_numClimb = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-l") == 0 && hasValue)
+        {
+            options.m_seconds = std::max(0.01, atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-s") == 0 && hasValue)
+        {
+            options.m_seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        }
+        else if (strcmp(argv[i], "-z") == 0)
+        {
+            options.m_subnormals = true;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && hasValue)
+        {
+            options.m_outDir = argv[++i];
+        }
+        else
+        {
+            return Usage(argv[0]);
+        }
+    }
+
+    if (options.m_app == "froggers")
+    {
+        return Search<Froggers>(options).Run();
+    }
+    else if (options.m_app == "poggers")
+    {
+        return Search<Poggers>(options).Run();
+    }
+
+    return Usage(argv[0]);
+}
\ No newline at end of file
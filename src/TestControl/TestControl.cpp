@@ -26,19 +26,28 @@ struct TestControl
         }
     }
 
-    void Process(AudioHandle::InputBuffer& in, AudioHandle::OutputBuffer& out, size_t size)
+    void GateCallback()
+    {
+    }
+
+    void ButtonCallback(int button)
+    {
+    }
+
+    // No stages: both channels pass straight through.
+    //
+    void ConfigPipeline(AudioPipeline* pipeline)
+    {
+    }
+
+    void BeginBlock(size_t size)
     {
-        for (size_t i = 0; i < size; i++)
-        {
-            out[0][i] = in[0][i];
-            out[1][i] = in[1][i];
-        }
     }
 };
 
 int main(void)
 {
-    App<TestControl> app;
+    static App<TestControl> app;
     app.LetsFuckingDoThisShit();
     return 0;
 }
\ No newline at end of file
@@ -1,17 +1,94 @@
 #pragma once
 
+#include "AudioPipeline.hpp"
 #include "DaisyIO.hpp"
+#include "Protection.hpp"
+#include "SilenceGate.hpp"
+#include "Trace.hpp"
+#include <type_traits>
 
+// Apps that read files (impulse responses, samples) declare
+// void LoadFiles(bool sdMounted), called from the main loop once the
+// hardware, presets and SD card are up.
+//
+template<typename T, typename = void>
+struct HasLoadFiles : std::false_type
+{
+};
+
+template<typename T>
+struct HasLoadFiles<T, std::void_t<decltype(std::declval<T&>().LoadFiles(true))>> : std::true_type
+{
+};
+
+// Apps that follow the gate clock declare
+// void SetClock(const ClockTracker* clock), called from Config.
+//
+template<typename T, typename = void>
+struct HasSetClock : std::false_type
+{
+};
+
+template<typename T>
+struct HasSetClock<T, std::void_t<decltype(std::declval<T&>().SetClock(nullptr))>> : std::true_type
+{
+};
+
+// Apps that take MIDI declare
+// void MidiCallback(const MidiEvent& event, size_t sampleOffset), called
+// for every message of the block (CCs and clock included) before BeginBlock.
+//
+template<typename T, typename = void>
+struct HasMidiCallback : std::false_type
+{
+};
+
+template<typename T>
+struct HasMidiCallback<T, std::void_t<decltype(std::declval<T&>().MidiCallback(std::declval<const MidiEvent&>(), size_t(0)))>> : std::true_type
+{
+};
+
+// Apps that apply remote knob moves (MIDI CCs) at their sample declare
+// void RemoteSetCallback(uint8_t page, uint8_t slot, float value, size_t
+// sampleOffset), called for each after BeginBlock. Without it, a CC is heard
+// from the top of its block, through Parameter::Get.
+//
+template<typename T, typename = void>
+struct HasRemoteSetCallback : std::false_type
+{
+};
+
+template<typename T>
+struct HasRemoteSetCallback<T, std::void_t<decltype(std::declval<T&>().RemoteSetCallback(uint8_t(0), uint8_t(0), 0.0f, size_t(0)))>> : std::true_type
+{
+};
+
+// The instance is static, so it goes in .bss in the 512K AXI SRAM next to
+// libDaisy's own buffers. The stack is the 128K DTCM and cannot hold an app
+// with delay lines in it.
+//
 template<typename T>
 struct App
 {
+    static constexpr size_t x_maxSize = 448 * 1024;
+
     DaisyIO m_daisyIO;
     T m_app;
+    AudioPipeline m_pipeline;
+    SilenceGate m_silenceGate;
     static App* s_instance;
 
     void Config()
     {
         m_app.Config(&m_daisyIO.m_pageManager);
+        if constexpr (HasSetClock<T>::value)
+        {
+            m_app.SetClock(&m_daisyIO.m_clock);
+        }
+
+        m_daisyIO.m_morph.Config(&m_daisyIO.m_pageManager);
+        m_app.ConfigPipeline(&m_pipeline);
+        m_pipeline.Plan();
     }
 
     static void StaticProcess(daisy::AudioHandle::InputBuffer in, daisy::AudioHandle::OutputBuffer out, size_t size)
@@ -37,15 +114,76 @@ struct App
 
     void Process(daisy::AudioHandle::InputBuffer& in, daisy::AudioHandle::OutputBuffer& out, size_t size)
     {
-        m_app.Process(in, out, size);
+        uint32_t start = daisy::System::GetUs();
+        m_daisyIO.ProcessMidi(size);
+        if (m_daisyIO.ProcessGate(size))
+        {
+            m_app.GateCallback();
+        }
+
+        if constexpr (HasMidiCallback<T>::value)
+        {
+            for (size_t i = 0; i < m_daisyIO.m_midi.m_numBlockEvents; i++)
+            {
+                m_app.MidiCallback(m_daisyIO.m_midi.m_blockEvents[i], m_daisyIO.m_midi.m_blockOffsets[i]);
+            }
+        }
+
+        m_daisyIO.m_morph.ProcessBlock();
+
+        m_app.BeginBlock(size);
+        if constexpr (HasRemoteSetCallback<T>::value)
+        {
+            for (size_t i = 0; i < m_daisyIO.m_numBlockRemotes; i++)
+            {
+                const DaisyIO::RemoteEvent& remote = m_daisyIO.m_blockRemotes[i];
+                m_app.RemoteSetCallback(remote.m_page, remote.m_slot, remote.m_value, remote.m_offset);
+            }
+        }
+
+        bool asleep = false;
+        if constexpr (HasTailSamples<T>::value)
+        {
+            asleep = m_silenceGate.Sleep(m_pipeline, in, size, m_app.TailSamples());
+        }
+
+        if (asleep)
+        {
+            SilenceGate::Silence(out, size);
+        }
+        else
+        {
+            m_pipeline.Process(in, out, size);
+
+            if constexpr (HasTailSamples<T>::value)
+            {
+                m_silenceGate.Observe(m_pipeline, out, size);
+            }
+        }
+
+        m_daisyIO.m_recorder.Capture(out, size);
+
+        // A block that takes longer than it lasts is a dropout.
+        //
+        uint32_t elapsed = daisy::System::GetUs() - start;
+        uint32_t budget = static_cast<uint32_t>(size * 1000000 / 48000);
+        if (budget < elapsed)
+        {
+            Trace::Emit(Trace::Event::BlockOverrun, elapsed, budget);
+        }
     }
 
     void Init()
     {
+        Protection::EnableFlushToZero();
         Config();
         m_daisyIO.m_buttonCallback = StaticButtonCallback;
         s_instance = this;
         m_daisyIO.Init(StaticProcess);
+        if constexpr (HasLoadFiles<T>::value)
+        {
+            m_app.LoadFiles(m_daisyIO.m_sdMounted);
+        }
     }
 
     void MainLoop()
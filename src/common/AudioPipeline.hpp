@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Per-channel chains of block stages between libDaisy's input and output
+// buffers. Apps register stages once from ConfigPipeline, and Plan() decides
+// at Config time which buffer each stage reads and writes, so the callback
+// just walks a flat list of calls with no copies between stages.
+//
+// A stage is a member function void(const float* in, float* out, size_t size).
+// InPlace stages accept in == out; OutOfPlace stages need distinct buffers,
+// and get one from the scratch pool only when the chain needs it.
+//
+struct AudioPipeline
+{
+    static constexpr size_t x_numChannels = 2;
+    static constexpr size_t x_maxStages = 8;
+    static constexpr size_t x_maxBlockSize = 48;
+
+    typedef void (*ProcessFn)(void* stage, const float* in, float* out, size_t size);
+
+    enum class Mode : uint8_t
+    {
+        InPlace = 0,
+        OutOfPlace = 1,
+    };
+
+    // What a channel with no stages does.
+    //
+    enum class EmptyMode : uint8_t
+    {
+        PassThrough = 0,
+        Silence = 1,
+    };
+
+    // Buffers are named by slot and bound to real pointers per callback,
+    // since libDaisy hands over a different DMA half each time.
+    //
+    enum class Slot : uint8_t
+    {
+        Input = 0,
+        Output = 1,
+        Scratch = 2,
+        NumSlots = 3,
+    };
+
+    struct Stage
+    {
+        ProcessFn m_process;
+        void* m_stage;
+        Mode m_mode;
+    };
+
+    struct Step
+    {
+        ProcessFn m_process;
+        void* m_stage;
+        Slot m_in;
+        Slot m_out;
+    };
+
+    Stage m_stages[x_numChannels][x_maxStages];
+    Step m_plan[x_numChannels][x_maxStages];
+    size_t m_numStages[x_numChannels];
+    EmptyMode m_emptyMode[x_numChannels];
+    float m_scratch[x_numChannels][x_maxBlockSize];
+
+    AudioPipeline()
+        : m_stages{}
+        , m_plan{}
+        , m_numStages{}
+        , m_emptyMode{}
+        , m_scratch{}
+    {
+    }
+
+    template<typename T, void (T::*Method)(const float*, float*, size_t)>
+    static void Trampoline(void* stage, const float* in, float* out, size_t size)
+    {
+        (static_cast<T*>(stage)->*Method)(in, out, size);
+    }
+
+    template<typename T, void (T::*Method)(const float*, float*, size_t)>
+    void AddStage(size_t channel, T* stage, Mode mode)
+    {
+        if (x_maxStages <= m_numStages[channel])
+        {
+            return;
+        }
+
+        m_stages[channel][m_numStages[channel]] = Stage{Trampoline<T, Method>, stage, mode};
+        m_numStages[channel]++;
+    }
+
+    void SetEmptyMode(size_t channel, EmptyMode mode)
+    {
+        m_emptyMode[channel] = mode;
+    }
+
+    // Resolve buffers back to front. The last stage writes Output. An InPlace
+    // stage reads the buffer it writes; an OutOfPlace stage reads the other of
+    // Output and Scratch. The first stage always reads Input, which is never
+    // written.
+    //
+    void Plan()
+    {
+        for (size_t channel = 0; channel < x_numChannels; channel++)
+        {
+            Slot out = Slot::Output;
+            for (size_t i = m_numStages[channel]; 0 < i; i--)
+            {
+                const Stage& stage = m_stages[channel][i - 1];
+                Slot in = out;
+                if (i == 1)
+                {
+                    in = Slot::Input;
+                }
+                else if (stage.m_mode == Mode::OutOfPlace)
+                {
+                    in = out == Slot::Output ? Slot::Scratch : Slot::Output;
+                }
+
+                m_plan[channel][i - 1] = Step{stage.m_process, stage.m_stage, in, out};
+                out = in;
+            }
+        }
+    }
+
+    void ProcessChannel(size_t channel, const float* in, float* out, size_t size)
+    {
+        if (m_numStages[channel] == 0)
+        {
+            if (m_emptyMode[channel] == EmptyMode::PassThrough)
+            {
+                memcpy(out, in, size * sizeof(float));
+            }
+            else
+            {
+                memset(out, 0, size * sizeof(float));
+            }
+
+            return;
+        }
+
+        float* buffers[static_cast<size_t>(Slot::NumSlots)] = {const_cast<float*>(in), out, m_scratch[channel]};
+        for (size_t i = 0; i < m_numStages[channel]; i++)
+        {
+            const Step& step = m_plan[channel][i];
+            step.m_process(step.m_stage, buffers[static_cast<size_t>(step.m_in)], buffers[static_cast<size_t>(step.m_out)], size);
+        }
+    }
+
+    template<typename InputBuffer, typename OutputBuffer>
+    void Process(InputBuffer& in, OutputBuffer& out, size_t size)
+    {
+        // Scratch buffers hold one block; larger callbacks run in pieces.
+        //
+        for (size_t offset = 0; offset < size; offset += x_maxBlockSize)
+        {
+            size_t chunk = std::min(x_maxBlockSize, size - offset);
+            for (size_t channel = 0; channel < x_numChannels; channel++)
+            {
+                ProcessChannel(channel, in[channel] + offset, out[channel] + offset, chunk);
+            }
+        }
+    }
+};
\ No newline at end of file
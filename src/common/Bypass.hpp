@@ -0,0 +1,105 @@
+#pragma once
+
+#include "StaticGraph.hpp"
+#include <cstddef>
+#include <type_traits>
+
+// Skips a stage while its settings make it transparent. The stage declares
+// bool IsNeutral() const over its current (smoothed) settings; once per
+// block UpdateBypass() checks it and fades the stage out across the next
+// block, after which Process() passes the input straight through without
+// calling the stage. When the settings leave neutral the stage fades back in
+// the same way. Decisions are made at block starts, so a stage wakes up to a
+// block after its knob moves.
+//
+// While bypassed, a stage that declares void FeedBypassed(float input) gets
+// every input so it can keep its delay lines current. Any other stage is
+// Reset() when it wakes, so it does not replay stale state into the fade.
+//
+template<typename Stage, typename = void>
+struct HasFeedBypassed : std::false_type
+{
+};
+
+template<typename Stage>
+struct HasFeedBypassed<Stage, std::void_t<decltype(std::declval<Stage&>().FeedBypassed(0.0f))>> : std::true_type
+{
+};
+
+template<typename Stage>
+struct Bypassable
+{
+    Stage m_stage;
+    float m_mix;
+    float m_targetMix;
+    float m_mixStep;
+
+    Bypassable()
+        : m_stage()
+        , m_mix(1.0f)
+        , m_targetMix(1.0f)
+        , m_mixStep(0.0f)
+    {
+    }
+
+    bool IsBypassed() const
+    {
+        return m_mix == 0.0f && m_mixStep == 0.0f;
+    }
+
+    // Once per block, before the block's Process() calls. The previous fade
+    // has finished by now, so it lands exactly on its target.
+    //
+    void UpdateBypass(size_t size)
+    {
+        bool wasBypassed = IsBypassed();
+        m_mix = m_targetMix;
+        m_targetMix = m_stage.IsNeutral() ? 0.0f : 1.0f;
+        m_mixStep = (m_targetMix - m_mix) / size;
+
+        if constexpr (!HasFeedBypassed<Stage>::value)
+        {
+            if (wasBypassed && !IsBypassed())
+            {
+                m_stage.Reset();
+            }
+        }
+    }
+
+    float Process(float input)
+    {
+        if (m_mixStep == 0.0f)
+        {
+            if (m_mix == 0.0f)
+            {
+                if constexpr (HasFeedBypassed<Stage>::value)
+                {
+                    m_stage.FeedBypassed(input);
+                }
+
+                return input;
+            }
+
+            return m_stage.Process(input);
+        }
+
+        m_mix += m_mixStep;
+        float wet = m_stage.Process(input);
+        return input + m_mix * (wet - input);
+    }
+
+    size_t TailSamples() const
+    {
+        return IsBypassed() ? 0 : m_stage.TailSamples();
+    }
+
+    bool IsFinite() const
+    {
+        return m_stage.IsFinite();
+    }
+
+    void Reset()
+    {
+        m_stage.Reset();
+    }
+};
\ No newline at end of file
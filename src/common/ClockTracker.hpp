@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Tempo and beat phase from clock pulses on the gate input, run from the
+// audio callback once per block. The Field reads the gate pin once per block,
+// so edges arrive stamped to the block (up to 1ms late); the tracker filters
+// that jitter out and hands apps a steady, sample-accurate beat.
+//
+// The period is a running average of edge intervals. An interval more than
+// x_tolerance off the average is ignored as jitter or a missed pulse, unless
+// x_relockEdges of them agree, which is taken as a tempo change. Phase
+// counts beats; on each edge x_phaseGain of the distance to the nearest
+// whole beat is slewed out over x_slewSamples by bending the rate, never by
+// jumping, so beat ticks are never skipped or repeated.
+//
+// Unlocked (fewer than three edges, or none for two periods) apps should
+// fall back to their free-running behaviour.
+//
+struct ClockTracker
+{
+    static constexpr double x_minPeriod = 2400.0;
+    static constexpr double x_maxPeriod = 144000.0;
+    static constexpr double x_tolerance = 0.2;
+    static constexpr double x_averaging = 0.25;
+    static constexpr size_t x_relockEdges = 2;
+    static constexpr double x_slewSamples = 2400.0;
+    static constexpr double x_phaseGain = 0.5;
+
+    // Beats wrap at x_phaseWrap, a multiple of every supported division.
+    //
+    static constexpr double x_phaseWrap = 192.0;
+
+    uint64_t m_lastEdgeTime;
+    size_t m_numEdges;
+    size_t m_outliers;
+    double m_period;
+    bool m_locked;
+
+    double m_phase;
+    double m_blockIncrement;
+    double m_correction;
+
+    ClockTracker()
+        : m_lastEdgeTime(0)
+        , m_numEdges(0)
+        , m_outliers(0)
+        , m_period(24000.0)
+        , m_locked(false)
+        , m_phase(0.0)
+        , m_blockIncrement(0.0)
+        , m_correction(0.0)
+    {
+    }
+
+    bool IsLocked() const
+    {
+        return m_locked;
+    }
+
+    // Samples per beat.
+    //
+    double Period() const
+    {
+        return m_period;
+    }
+
+    // Beats since an arbitrary origin, at the top of the current block.
+    //
+    double Phase() const
+    {
+        return m_phase;
+    }
+
+    // Once per block, before anything reads the clock. edgeTime is when the
+    // edge (if any) landed, in the same sample clock as blockStart.
+    //
+    void Process(bool edge, uint64_t edgeTime, uint64_t blockStart, size_t size)
+    {
+        m_phase = std::fmod(m_phase + m_blockIncrement, x_phaseWrap);
+
+        if (edge)
+        {
+            OnEdge(edgeTime);
+        }
+        else if (m_locked && 2.0 * m_period < static_cast<double>(blockStart - m_lastEdgeTime))
+        {
+            SetLocked(false);
+            m_numEdges = 0;
+        }
+
+        double increment = size / m_period;
+        double slew = m_correction * std::min(1.0, size / x_slewSamples);
+        slew = std::min(std::max(slew, -0.5 * increment), increment);
+        m_correction -= slew;
+        m_blockIncrement = increment + slew;
+    }
+
+    void OnEdge(uint64_t edgeTime)
+    {
+        double interval = static_cast<double>(edgeTime - m_lastEdgeTime);
+        m_lastEdgeTime = edgeTime;
+
+        if (m_numEdges == 0 || interval < x_minPeriod || x_maxPeriod < interval)
+        {
+            m_numEdges = 1;
+            m_outliers = 0;
+            SetLocked(false);
+            return;
+        }
+
+        if (m_numEdges == 1)
+        {
+            m_period = interval;
+            m_numEdges = 2;
+            return;
+        }
+
+        if (std::abs(interval - m_period) <= x_tolerance * m_period)
+        {
+            m_period += x_averaging * (interval - m_period);
+            m_outliers = 0;
+        }
+        else if (++m_outliers < x_relockEdges)
+        {
+            return;
+        }
+        else
+        {
+            m_period = interval;
+            m_outliers = 0;
+            SetLocked(false);
+        }
+
+        m_numEdges++;
+        if (!m_locked)
+        {
+            // Nothing has used the phase yet, so it can jump.
+            //
+            SetLocked(true);
+            m_phase = std::floor(m_phase + 0.5);
+            m_correction = 0.0;
+        }
+        else
+        {
+            m_correction = x_phaseGain * (std::floor(m_phase + 0.5) - m_phase);
+        }
+    }
+
+    // Lock changes are traced, since a lost clock is hard to see otherwise.
+    //
+    void SetLocked(bool locked)
+    {
+        if (locked != m_locked)
+        {
+            Trace::Emit(locked ? Trace::Event::ClockLock : Trace::Event::ClockUnlock, static_cast<uint32_t>(m_period));
+        }
+
+        m_locked = locked;
+    }
+
+    // Offset into the current block (of size samples) of the first tick at
+    // ticksPerBeat ticks per beat, or SIZE_MAX if none falls in it. Ticks are
+    // on whole multiples of 1 / ticksPerBeat beats, so x_phaseWrap *
+    // ticksPerBeat must be a whole number.
+    //
+    size_t TickOffset(size_t size, double ticksPerBeat) const
+    {
+        if (!m_locked || m_blockIncrement <= 0.0)
+        {
+            return SIZE_MAX;
+        }
+
+        // A tick between two samples goes to the earlier one, so the blocks
+        // split the phase into [start, end) ranges and none is lost or
+        // repeated across a block boundary.
+        //
+        double ticks = m_phase * ticksPerBeat;
+        double next = std::ceil(ticks);
+        double offset = std::floor((next - ticks) / (m_blockIncrement * ticksPerBeat / size));
+        return offset < size ? static_cast<size_t>(offset) : SIZE_MAX;
+    }
+};
\ No newline at end of file
@@ -1,9 +1,19 @@
 #pragma once
 
 #include "SmartGridInclude.hpp"
+#include "ParamTable.hpp"
+#include "FastMath.hpp"
+#include "StaticGraph.hpp"
+#include <cstring>
 
-struct Comb
+// Tier picks the feedback saturator: TanhSaturator for Reference, otherwise
+// FastMath's tanh(g x) / g with the same g.
+//
+template<MathTier Tier>
+struct BasicComb
 {
+    static constexpr float x_saturatorGain = 0.5f;
+
     OPLowPassFilter m_filter;
     static constexpr size_t x_size = 8192;
     float m_delayLine[x_size];
@@ -13,14 +23,14 @@ struct Comb
     float m_output;
     TanhSaturator<true> m_saturator;
 
-    Comb()
+    BasicComb()
         : m_filter()
         , m_delayLine{0.0f}
         , m_index(0)
         , m_delaySamples(0)
         , m_feedback(0.0f)
         , m_output(0.0f)
-        , m_saturator(0.5)
+        , m_saturator(x_saturatorGain)
     {
     }
 
@@ -36,18 +46,86 @@ struct Comb
 
     float Process(float input)
     {
-        float output = input + m_feedback * m_saturator.Process(m_filter.Process(m_delayLine[(m_index + x_size - m_delaySamples) % x_size]));
+        float filtered = m_filter.Process(m_delayLine[(m_index + x_size - m_delaySamples) % x_size]);
+        float saturated;
+        if constexpr (Tier == MathTier::Reference)
+        {
+            saturated = m_saturator.Process(filtered);
+        }
+        else
+        {
+            saturated = FastMath<Tier>::Tanh(x_saturatorGain * filtered) * (1.0f / x_saturatorGain);
+        }
+
+        float output = input + m_feedback * saturated;
         m_output = output;
         m_delayLine[m_index] = output;
         m_index = (m_index + 1) % x_size;
         return output;
     }
 
+    // Below x_neutralFeedback (-40dB) the echoes are inaudible and the comb
+    // can be bypassed; see Bypass.hpp. With no feedback the comb would write
+    // its input, so bypassed samples do the same.
+    //
+    static constexpr float x_neutralFeedback = 0.01f;
+
+    bool IsNeutral() const
+    {
+        return std::abs(m_feedback) < x_neutralFeedback;
+    }
+
+    // The saturator only shrinks the loop gain, so the linear decay bounds
+    // the tail.
+    //
+    size_t TailSamples() const
+    {
+        return StageTail::Decay(m_delaySamples, m_feedback);
+    }
+
+    void FeedBypassed(float input)
+    {
+        m_output = input;
+        m_delayLine[m_index] = input;
+        m_index = (m_index + 1) % x_size;
+    }
+
+    // A non-finite sample latches in the lowpass and then recirculates, so the
+    // last output is enough to catch it.
+    //
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output);
+    }
+
+    void Reset()
+    {
+        float alpha = m_filter.m_alpha;
+        m_filter = OPLowPassFilter();
+        m_filter.m_alpha = alpha;
+        memset(m_delayLine, 0, sizeof(m_delayLine));
+        m_output = 0.0f;
+    }
+
     static float GetDelaySamples(float freq)
     {
         return 1.0 / freq;
     }
 
+    // GetFeedback evaluated at compile time, for FeedbackTable.
+    //
+    struct FeedbackCurve
+    {
+        static constexpr double Compute(double knob)
+        {
+            double amount = knob < 0.5 ? 2 * (0.5 - knob) : 2 * (knob - 0.5);
+            double shaped = (ConstMath::Pow(0.25, amount) - 1.0) / (0.25 - 1.0);
+            return knob < 0.5 ? -1.1 * shaped : 1.1 * shaped;
+        }
+    };
+
+    using FeedbackTable = ParamTable<FeedbackCurve>;
+
     static float GetFeedback(float knob)
     {
         if (knob < 0.5f)
@@ -61,6 +139,8 @@ struct Comb
     }
 };
 
+using Comb = BasicComb<MathTier::Reference>;
+
 struct PureDelay
 {
     static constexpr size_t x_size = 8192;
@@ -91,4 +171,19 @@ struct PureDelay
         m_index = (m_index + 1) % x_size;
         return output;
     }
+
+    size_t TailSamples() const
+    {
+        return static_cast<size_t>(m_delaySamples) + 2;
+    }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_delayLine[(m_index + x_size - 1) % x_size]);
+    }
+
+    void Reset()
+    {
+        memset(m_delayLine, 0, sizeof(m_delayLine));
+    }
 };
\ No newline at end of file
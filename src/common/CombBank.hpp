@@ -0,0 +1,187 @@
+#pragma once
+
+#include "ParamTable.hpp"
+#include "StaticGraph.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// N feedback combs tuned to the ratios of a chord, summed. State is laid out
+// by voice: delay lengths, lowpass states and so on sit in contiguous
+// arrays, and the delay lines are interleaved so all voices write one
+// contiguous frame per sample. Apart from the delay-line gather, the voice
+// loop is straight-line arithmetic the compiler can vectorize.
+//
+// Each voice is y = x + g * clamp(lp(y[n - d])). The clamp is a safety
+// bound only; g stays below 1 and the lowpass has unity gain, so the bank is
+// stable without a saturator.
+//
+template<size_t N>
+struct CombBank
+{
+    static constexpr size_t x_size = 4096;
+    static constexpr size_t x_mask = x_size - 1;
+    static constexpr size_t x_maxVoices = 8;
+    static constexpr size_t x_numChords = 7;
+    static constexpr float x_clamp = 2.0f;
+
+    static_assert(N <= x_maxVoices, "CombBank supports up to 8 voices");
+
+    // Frequency ratios to the root, up to eight voices each: harmonic,
+    // major, minor, sus4, stacked fifths, octaves, and a bell-like
+    // inharmonic set.
+    //
+    static constexpr float x_chords[x_numChords][x_maxVoices] =
+    {
+        {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f},
+        {1.0f, 1.25f, 1.5f, 2.0f, 2.5f, 3.0f, 4.0f, 5.0f},
+        {1.0f, 1.2f, 1.5f, 2.0f, 2.4f, 3.0f, 4.0f, 4.8f},
+        {1.0f, 1.3333f, 1.5f, 2.0f, 2.6667f, 3.0f, 4.0f, 5.3333f},
+        {1.0f, 1.5f, 2.25f, 3.375f, 5.0625f, 7.5938f, 11.3906f, 17.0859f},
+        {1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f, 128.0f},
+        {1.0f, 2.756f, 5.404f, 8.933f, 13.345f, 18.638f, 24.812f, 31.870f},
+    };
+
+    // Knob to feedback, 0 to 0.999.
+    //
+    struct FeedbackCurve
+    {
+        static constexpr double Compute(double knob)
+        {
+            return 1.0 - ConstMath::Pow(0.001, knob);
+        }
+    };
+
+    using FeedbackTable = ParamTable<FeedbackCurve>;
+
+    float m_lines[x_size][N];
+    float m_lowpass[N];
+    uint32_t m_delay[N];
+    size_t m_index;
+
+    float m_freq;
+    uint8_t m_chord;
+    float m_feedback;
+    float m_alpha;
+    float m_mix;
+    float m_output;
+
+    CombBank()
+        : m_lines{}
+        , m_lowpass{}
+        , m_delay{}
+        , m_index(0)
+        , m_freq(0.01f)
+        , m_chord(0)
+        , m_feedback(0.0f)
+        , m_alpha(1.0f)
+        , m_mix(0.0f)
+        , m_output(0.0f)
+    {
+        UpdateDelays();
+    }
+
+    // Root frequency in cycles per sample.
+    //
+    void SetFreq(float freq)
+    {
+        m_freq = freq;
+        UpdateDelays();
+    }
+
+    void SetChord(float knob)
+    {
+        m_chord = std::min(static_cast<size_t>(knob * x_numChords), x_numChords - 1);
+        UpdateDelays();
+    }
+
+    void SetFeedback(float feedback)
+    {
+        m_feedback = feedback;
+    }
+
+    void SetCutoffAlpha(float alpha)
+    {
+        m_alpha = alpha;
+    }
+
+    void SetMix(float mix)
+    {
+        m_mix = mix;
+    }
+
+    // One division per update, then a multiply per voice.
+    //
+    void UpdateDelays()
+    {
+        float rootDelay = 1.0f / std::max(m_freq, 1e-6f);
+        for (size_t i = 0; i < N; i++)
+        {
+            float delay = rootDelay / x_chords[m_chord][i];
+            m_delay[i] = static_cast<uint32_t>(std::min(std::max(delay, 1.0f), static_cast<float>(x_size - 1)));
+        }
+    }
+
+    float Process(float input)
+    {
+        float delayed[N];
+        for (size_t i = 0; i < N; i++)
+        {
+            delayed[i] = m_lines[(m_index - m_delay[i]) & x_mask][i];
+        }
+
+        float* frame = m_lines[m_index];
+        float wet = 0.0f;
+        for (size_t i = 0; i < N; i++)
+        {
+            m_lowpass[i] += m_alpha * (delayed[i] - m_lowpass[i]);
+            float output = input + m_feedback * std::min(std::max(m_lowpass[i], -x_clamp), x_clamp);
+            frame[i] = output;
+            wet += output;
+        }
+
+        m_index = (m_index + 1) & x_mask;
+        m_output = wet * (1.0f / N);
+        return input + m_mix * (m_output - input);
+    }
+
+    // Fully dry; see Bypass.hpp. Bypassed samples fill every voice's line
+    // with the input, so the bank wakes up with a plausible history.
+    //
+    bool IsNeutral() const
+    {
+        return m_mix == 0.0f;
+    }
+
+    // The root voice has the longest delay and so the longest tail.
+    //
+    size_t TailSamples() const
+    {
+        return StageTail::Decay(static_cast<float>(*std::max_element(m_delay, m_delay + N)), m_feedback);
+    }
+
+    void FeedBypassed(float input)
+    {
+        float* frame = m_lines[m_index];
+        for (size_t i = 0; i < N; i++)
+        {
+            frame[i] = input;
+        }
+
+        m_index = (m_index + 1) & x_mask;
+    }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output);
+    }
+
+    void Reset()
+    {
+        memset(m_lines, 0, sizeof(m_lines));
+        memset(m_lowpass, 0, sizeof(m_lowpass));
+        m_output = 0.0f;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "FFT.hpp"
+#include "StaticGraph.hpp"
+#include "WavFormat.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#ifdef HOST_BUILD
+#include <memory>
+#else
+#include "daisy_field.h"
+#endif
+
+// Convolution with a long impulse response (cabinet, body resonance), mixed
+// with the dry signal. The IR is split three ways so the cost per sample stays
+// low without adding latency:
+//
+//   taps [0, 64)        direct FIR, so the output has no delay
+//   taps [64, 1024)     64-tap partitions, overlap-save with 128-point FFTs,
+//                       run inside the callback every 64 samples
+//   taps [1024, end)    512-tap partitions, 1024-point FFTs
+//
+// Each level only needs its result once the level before it runs out, which
+// for the tail is a full 512 samples after its input block completes. The
+// tail's work for one block (a forward FFT, a multiply-add per partition and
+// an inverse FFT) is therefore cut into steps and spread over the callbacks
+// of the following block, instead of landing in a single callback.
+//
+// Spectra and the frequency-domain input history scale with the IR, so they
+// live in Storage, in SDRAM on the target. The SDRAM is not up when apps are
+// constructed, so nothing touches Storage until an IR is loaded. The history
+// is never cleared in the callback, which would mean hundreds of kilobytes of
+// SDRAM writes; instead only the slots written since the last wake-up are
+// summed.
+//
+struct Convolver
+{
+    static constexpr size_t x_headSize = 64;
+    static constexpr size_t x_tailSize = 512;
+    static constexpr size_t x_tailOffset = 2 * x_tailSize;
+    static constexpr size_t x_maxLength = 32768;
+    static constexpr size_t x_numHeadPartitions = x_tailOffset / x_headSize - 1;
+    static constexpr size_t x_numTailPartitions = (x_maxLength - x_tailOffset) / x_tailSize;
+    static constexpr size_t x_partitionsPerStep = 4;
+
+    typedef RealFFT<2 * x_headSize> HeadFFT;
+    typedef RealFFT<2 * x_tailSize> TailFFT;
+
+    struct Storage
+    {
+        float m_ir[x_maxLength];
+        float m_headSpectra[x_numHeadPartitions][2 * x_headSize];
+        float m_headHistory[x_numHeadPartitions][2 * x_headSize];
+        float m_tailSpectra[x_numTailPartitions][2 * x_tailSize];
+        float m_tailHistory[x_numTailPartitions][2 * x_tailSize];
+    };
+
+    Storage* m_storage;
+#ifdef HOST_BUILD
+    std::unique_ptr<Storage> m_hostStorage;
+#endif
+
+    HeadFFT m_headFFT;
+    TailFFT m_tailFFT;
+
+    std::atomic<bool> m_ready;
+    size_t m_length;
+    size_t m_numHead;
+    size_t m_numTail;
+    size_t m_numTailSteps;
+
+    float m_firTaps[x_headSize];
+    float m_firHistory[2 * x_headSize];
+    size_t m_firPos;
+
+    float m_headInput[2 * x_headSize];
+    float m_headScratch[2 * x_headSize];
+    float m_headOutput[x_headSize];
+    size_t m_headPos;
+    size_t m_headIndex;
+    size_t m_headFilled;
+
+    float m_tailInput[2 * x_tailSize];
+    float m_tailJob[2 * x_tailSize];
+    float m_tailAccum[2 * x_tailSize];
+    float m_tailOutput[2][x_tailSize];
+    size_t m_tailPos;
+    size_t m_tailIndex;
+    size_t m_tailFilled;
+    size_t m_tailRead;
+    size_t m_tailStep;
+
+    float m_mix;
+    float m_mixValue;
+    bool m_idle;
+    float m_output;
+
+    Convolver()
+        : m_storage(nullptr)
+        , m_ready(false)
+        , m_length(0)
+        , m_numHead(0)
+        , m_numTail(0)
+        , m_numTailSteps(0)
+        , m_firTaps{}
+        , m_firHistory{}
+        , m_firPos(0)
+        , m_headInput{}
+        , m_headScratch{}
+        , m_headOutput{}
+        , m_headPos(0)
+        , m_headIndex(0)
+        , m_headFilled(0)
+        , m_tailInput{}
+        , m_tailJob{}
+        , m_tailAccum{}
+        , m_tailOutput{}
+        , m_tailPos(0)
+        , m_tailIndex(0)
+        , m_tailFilled(0)
+        , m_tailRead(0)
+        , m_tailStep(0)
+        , m_mix(0.0f)
+        , m_mixValue(0.0f)
+        , m_idle(true)
+        , m_output(0.0f)
+    {
+    }
+
+    // One convolver per firmware on the target: there is one SDRAM block.
+    //
+    Storage* GetStorage()
+    {
+        if (!m_storage)
+        {
+#ifdef HOST_BUILD
+            m_hostStorage.reset(new Storage());
+            m_storage = m_hostStorage.get();
+#else
+            static Storage s_storage DSY_SDRAM_BSS;
+            m_storage = &s_storage;
+#endif
+        }
+
+        return m_storage;
+    }
+
+    // Main loop, never while the audio callback could be using the old IR:
+    // call it once at startup, before anything sets the mix. Longer IRs are
+    // truncated to x_maxLength.
+    //
+    void SetImpulse(const float* ir, size_t length)
+    {
+        m_ready.store(false, std::memory_order_release);
+        Storage* storage = GetStorage();
+
+        length = std::min(length, x_maxLength);
+        memcpy(storage->m_ir, ir, length * sizeof(float));
+        NormalizeImpulse(length);
+    }
+
+    // Reads the first channel of a WAV from any Source with Read and Skip
+    // (see WavFormat), straight into Storage.
+    //
+    template<typename Source>
+    bool Load(Source* source)
+    {
+        WavFormat format;
+        if (!format.ReadHeader(source) || format.m_numChannels == 0)
+        {
+            return false;
+        }
+
+        m_ready.store(false, std::memory_order_release);
+        Storage* storage = GetStorage();
+
+        size_t frameBytes = format.BytesPerFrame();
+        size_t length = std::min(format.NumFrames(), x_maxLength);
+        uint8_t frame[64];
+        if (sizeof(frame) < frameBytes)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (!source->Read(frame, frameBytes))
+            {
+                length = i;
+                break;
+            }
+
+            storage->m_ir[i] = format.DecodeSample(frame);
+        }
+
+        NormalizeImpulse(length);
+        return true;
+    }
+
+    // The first length samples of Storage's IR are in place. Scale them to
+    // unit energy so different files come out at a similar level, clear the
+    // rest, then cut into partitions and transform.
+    //
+    void NormalizeImpulse(size_t length)
+    {
+        Storage* storage = m_storage;
+        double energy = 0.0;
+        for (size_t i = 0; i < length; i++)
+        {
+            energy += static_cast<double>(storage->m_ir[i]) * storage->m_ir[i];
+        }
+
+        float scale = 0.0 < energy ? static_cast<float>(1.0 / std::sqrt(energy)) : 0.0f;
+        for (size_t i = 0; i < length; i++)
+        {
+            storage->m_ir[i] *= scale;
+        }
+
+        memset(storage->m_ir + length, 0, (x_maxLength - length) * sizeof(float));
+        PrepareImpulse(length);
+    }
+
+    void PrepareImpulse(size_t length)
+    {
+        Storage* storage = m_storage;
+        m_length = length;
+
+        for (size_t i = 0; i < x_headSize; i++)
+        {
+            m_firTaps[i] = storage->m_ir[x_headSize - 1 - i];
+        }
+
+        // The inverse FFTs are unscaled, so the spectra carry the 1 / N.
+        //
+        m_numHead = std::min((std::max(length, x_headSize) - x_headSize + x_headSize - 1) / x_headSize, x_numHeadPartitions);
+        for (size_t j = 0; j < m_numHead; j++)
+        {
+            float* spectrum = storage->m_headSpectra[j];
+            memset(spectrum, 0, sizeof(storage->m_headSpectra[j]));
+            for (size_t i = 0; i < x_headSize; i++)
+            {
+                spectrum[i] = storage->m_ir[(j + 1) * x_headSize + i] * (1.0f / (2 * x_headSize));
+            }
+
+            m_headFFT.Forward(spectrum, spectrum);
+        }
+
+        m_numTail = length <= x_tailOffset ? 0 : std::min((length - x_tailOffset + x_tailSize - 1) / x_tailSize, x_numTailPartitions);
+        for (size_t j = 0; j < m_numTail; j++)
+        {
+            float* spectrum = storage->m_tailSpectra[j];
+            memset(spectrum, 0, sizeof(storage->m_tailSpectra[j]));
+            for (size_t i = 0; i < x_tailSize; i++)
+            {
+                spectrum[i] = storage->m_ir[x_tailOffset + j * x_tailSize + i] * (1.0f / (2 * x_tailSize));
+            }
+
+            m_tailFFT.Forward(spectrum, spectrum);
+        }
+
+        // Forward transform, the multiply-add groups, inverse transform.
+        //
+        m_numTailSteps = m_numTail ? 2 + (m_numTail + x_partitionsPerStep - 1) / x_partitionsPerStep : 0;
+
+        ClearState();
+        m_ready.store(true, std::memory_order_release);
+    }
+
+    // Cheap enough for the callback: Storage is left alone.
+    //
+    void ClearState()
+    {
+        memset(m_firHistory, 0, sizeof(m_firHistory));
+        memset(m_headInput, 0, sizeof(m_headInput));
+        memset(m_headOutput, 0, sizeof(m_headOutput));
+        memset(m_tailInput, 0, sizeof(m_tailInput));
+        memset(m_tailOutput, 0, sizeof(m_tailOutput));
+        m_firPos = 0;
+        m_headPos = 0;
+        m_headIndex = 0;
+        m_headFilled = 0;
+        m_tailPos = 0;
+        m_tailIndex = 0;
+        m_tailFilled = 0;
+        m_tailRead = 0;
+        m_tailStep = m_numTailSteps;
+        m_output = 0.0f;
+    }
+
+    void SetMix(float mix)
+    {
+        m_mix = mix;
+    }
+
+    // Every 64 samples: transform the last two head blocks, multiply-add
+    // against the head partitions, and keep the valid half for the next 64
+    // samples.
+    //
+    void RunHead()
+    {
+        if (m_numHead == 0)
+        {
+            return;
+        }
+
+        Storage* storage = m_storage;
+        float* spectrum = storage->m_headHistory[m_headIndex];
+        m_headFFT.Forward(m_headInput, spectrum);
+        m_headFilled = std::min(m_headFilled + 1, x_numHeadPartitions);
+
+        memset(m_headScratch, 0, sizeof(m_headScratch));
+        for (size_t j = 0; j < std::min(m_numHead, m_headFilled); j++)
+        {
+            size_t index = (m_headIndex + x_numHeadPartitions - j) % x_numHeadPartitions;
+            HeadFFT::MultiplyAdd(storage->m_headHistory[index], storage->m_headSpectra[j], m_headScratch);
+        }
+
+        m_headFFT.Inverse(m_headScratch, m_headScratch);
+        memcpy(m_headOutput, m_headScratch + x_headSize, sizeof(m_headOutput));
+        m_headIndex = (m_headIndex + 1) % x_numHeadPartitions;
+    }
+
+    void RunTailStep()
+    {
+        Storage* storage = m_storage;
+        size_t numGroups = m_numTailSteps - 2;
+        if (m_tailStep == 0)
+        {
+            m_tailFFT.Forward(m_tailJob, storage->m_tailHistory[m_tailIndex]);
+            m_tailFilled = std::min(m_tailFilled + 1, x_numTailPartitions);
+            memset(m_tailAccum, 0, sizeof(m_tailAccum));
+        }
+        else if (m_tailStep <= numGroups)
+        {
+            size_t begin = (m_tailStep - 1) * x_partitionsPerStep;
+            size_t end = std::min(std::min(begin + x_partitionsPerStep, m_numTail), m_tailFilled);
+            for (size_t j = begin; j < end; j++)
+            {
+                size_t index = (m_tailIndex + x_numTailPartitions - j) % x_numTailPartitions;
+                TailFFT::MultiplyAdd(storage->m_tailHistory[index], storage->m_tailSpectra[j], m_tailAccum);
+            }
+        }
+        else
+        {
+            m_tailFFT.Inverse(m_tailAccum, m_tailAccum);
+            memcpy(m_tailOutput[1 - m_tailRead], m_tailAccum + x_tailSize, x_tailSize * sizeof(float));
+            m_tailIndex = (m_tailIndex + 1) % x_numTailPartitions;
+        }
+
+        m_tailStep++;
+    }
+
+    // A tail block just completed: finish the previous job, whose result is
+    // due now, and queue this block.
+    //
+    void StartTail()
+    {
+        while (m_tailStep < m_numTailSteps)
+        {
+            RunTailStep();
+        }
+
+        m_tailRead = 1 - m_tailRead;
+        memcpy(m_tailJob, m_tailInput, sizeof(m_tailJob));
+        memcpy(m_tailInput, m_tailInput + x_tailSize, x_tailSize * sizeof(float));
+        m_tailStep = 0;
+    }
+
+    float ProcessWet(float input)
+    {
+        m_firHistory[m_firPos] = input;
+        m_firHistory[m_firPos + x_headSize] = input;
+        const float* window = m_firHistory + m_firPos + 1;
+        float wet = 0.0f;
+        for (size_t i = 0; i < x_headSize; i++)
+        {
+            wet += m_firTaps[i] * window[i];
+        }
+
+        m_firPos = (m_firPos + 1) % x_headSize;
+
+        wet += m_headOutput[m_headPos] + m_tailOutput[m_tailRead][m_tailPos];
+        m_headInput[x_headSize + m_headPos] = input;
+        m_tailInput[x_tailSize + m_tailPos] = input;
+
+        if (++m_headPos == x_headSize)
+        {
+            m_headPos = 0;
+            RunHead();
+            memcpy(m_headInput, m_headInput + x_headSize, x_headSize * sizeof(float));
+        }
+
+        if (++m_tailPos == x_tailSize)
+        {
+            m_tailPos = 0;
+            if (m_numTail)
+            {
+                StartTail();
+            }
+        }
+
+        return wet;
+    }
+
+    // Dry until an IR is loaded, and idle (not computing) while the mix is
+    // fully dry. Waking clears the history so no stale input plays.
+    //
+    void ProcessBlock(const float* input, float* output, size_t size)
+    {
+        if (!m_ready.load(std::memory_order_acquire) || (m_mix == 0.0f && m_mixValue == 0.0f))
+        {
+            m_idle = true;
+            if (input != output)
+            {
+                memcpy(output, input, size * sizeof(float));
+            }
+
+            return;
+        }
+
+        if (m_idle)
+        {
+            m_idle = false;
+            ClearState();
+        }
+
+        float mixStep = (m_mix - m_mixValue) / size;
+        for (size_t i = 0; i < size; i++)
+        {
+            m_mixValue += mixStep;
+            float dry = input[i];
+            float wet = ProcessWet(dry);
+            output[i] = dry + m_mixValue * (wet - dry);
+        }
+
+        m_mixValue = m_mix;
+        m_output = output[size - 1];
+
+        // Spread the tail job evenly over the block that follows its input.
+        //
+        size_t due = m_numTailSteps * m_tailPos / x_tailSize;
+        while (m_tailStep < std::min(due, m_numTailSteps))
+        {
+            RunTailStep();
+        }
+    }
+
+    size_t TailSamples() const
+    {
+        return m_idle ? 0 : m_length;
+    }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output);
+    }
+
+    void Reset()
+    {
+        if (m_ready.load(std::memory_order_acquire))
+        {
+            ClearState();
+        }
+    }
+};
\ No newline at end of file
@@ -1,23 +1,111 @@
 #pragma once
 
 #include "Page.hpp"
-#include "SchmidtTrigger.hpp"
+#include "GateInput.hpp"
+#include "ClockTracker.hpp"
+#include "Midi.hpp"
+#include "Preset.hpp"
+#include "Morph.hpp"
+#include "Recorder.hpp"
+#include "Trace.hpp"
 #include "daisy_field.h"
 #include "daisysp.h"
+#include <atomic>
 #include <functional>
 
 struct DaisyIO
 {
+    static constexpr size_t x_shiftKey = 15;
+
+    // MIDI CCs from x_firstParamCc set knobs: eight per page, in page order,
+    // on any channel. MIDI clock (24 per beat) drives the ClockTracker in
+    // place of the gate while it runs.
+    //
+    static constexpr uint8_t x_firstParamCc = 16;
+    static constexpr uint32_t x_midiClocksPerBeat = 24;
+
+    // A CC that set a knob in this block, for apps that apply it at its
+    // sample.
+    //
+    struct RemoteEvent
+    {
+        uint8_t m_page;
+        uint8_t m_slot;
+        float m_value;
+        size_t m_offset;
+    };
+
     PageManager m_pageManager;
+    PresetManager m_presets;
+    MorphEngine m_morph;
     daisy::DaisyField m_field;
     std::function<void(int)> m_buttonCallback;
-    SchmidtTrigger m_gateTrigger{0.2f, 0.1f};
+    GateInput m_gateInput;
+    ClockTracker m_clock;
+    MidiInput m_midi;
+    uint32_t m_midiClocks;
+    bool m_midiBeat;
+    uint64_t m_midiBeatTime;
+    RemoteEvent m_blockRemotes[MidiInput::x_maxBlockEvents];
+    size_t m_numBlockRemotes;
+#ifndef HOST_BUILD
+    daisy::MidiUartTransport m_midiTransport;
+#endif
+    Recorder m_recorder;
+    bool m_sdMounted;
+#ifndef HOST_BUILD
+    daisy::SdmmcHandler m_sdmmc;
+    daisy::FatFSInterface m_fatfs;
+#endif
+
+    DaisyIO()
+        : m_midiClocks(0)
+        , m_midiBeat(false)
+        , m_midiBeatTime(0)
+        , m_numBlockRemotes(0)
+        , m_sdMounted(false)
+    {
+    }
+
+    // Main loop. The audio side already hears a CC through the parameter's
+    // m_remoteValue; this is the pickup bookkeeping, which is main loop state
+    // shared with the knobs. A newer CC stored meanwhile stays pending. Pages
+    // the morph owns ignore CCs, as they ignore the knobs.
+    //
+    void ApplyMidiCcs()
+    {
+        for (size_t page = 0; page < m_pageManager.m_numPages; page++)
+        {
+            for (size_t slot = 0; slot < Parameter::x_numParameters; slot++)
+            {
+                Parameter& parameter = m_pageManager.m_pages[page].m_parameters[slot];
+                uint8_t value = parameter.m_remoteValue.load(std::memory_order_acquire);
+                if (value == Parameter::x_noRemote)
+                {
+                    continue;
+                }
+
+                if (m_pageManager.m_numLockedPages <= page)
+                {
+                    m_pageManager.RemoteSet(page, slot, value / 127.0f);
+                }
+
+                parameter.m_remoteValue.compare_exchange_strong(value, Parameter::x_noRemote, std::memory_order_release);
+            }
+        }
+    }
 
     void ProcessControls()
     {
         m_field.ProcessAllControls();
+        ApplyMidiCcs();
 
-        if (m_pageManager.m_modIndex == 255)
+        bool shifted = m_field.KeyboardState(x_shiftKey);
+        if (shifted)
+        {
+            ProcessShiftedControls();
+        }
+        else if (m_pageManager.m_modIndex == 255)
         {
             if (m_field.sw[0].RisingEdge())
             {
@@ -52,20 +140,13 @@ struct DaisyIO
 
         for (size_t i = 0; i < 4; i++)
         {
-            if (m_field.KeyboardRisingEdge(i + 4))
+            if (!shifted && m_field.KeyboardRisingEdge(i + 4))
             {
                 m_buttonCallback(i);
             }
         }
 
-        // Check analog gate input for rising edge
-        //
-        if (m_gateTrigger.Process(m_field.gate_in.State()))
-        {
-            m_buttonCallback(0);
-        }
-
-        m_field.seed.SetLed(m_field.gate_in.State() ? 1.0f : 0.0f);
+        m_field.seed.SetLed(m_gateInput.State() ? 1.0f : 0.0f);
 
         m_field.SetCvOut1(m_pageManager.m_modMgr.m_mods[4] * 4096);
         m_field.SetCvOut2(m_pageManager.m_modMgr.m_mods[5] * 4096);
@@ -77,7 +158,7 @@ struct DaisyIO
                 m_pageManager.m_modMgr.m_mods[i] = m_field.GetCvValue(i);
             }
 
-            if (m_field.KeyboardRisingEdge(i + 8))
+            if (!shifted && m_field.KeyboardRisingEdge(i + 8))
             {
                 m_pageManager.StartModTracking(i);
             }
@@ -98,6 +179,136 @@ struct DaisyIO
         m_field.led_driver.SwapBuffersAndTransmit();
     }
 
+    // Holding the shift key turns the bottom row into preset slots: shift + key
+    // recalls a slot, shift + right switch saves into the last used slot.
+    // On the top row, shift + the first four keys capture morph A, capture
+    // morph B, randomize morph B and release the morph; the fifth starts and
+    // stops recording to the SD card.
+    //
+    void ProcessShiftedControls()
+    {
+        for (size_t i = 0; i < PresetManager::x_numSlots; i++)
+        {
+            if (m_field.KeyboardRisingEdge(i))
+            {
+                if (m_presets.Recall(i))
+                {
+                    Trace::Emit(Trace::Event::PresetRecall, static_cast<uint32_t>(i));
+                }
+            }
+        }
+
+        if (m_field.sw[1].RisingEdge())
+        {
+            m_presets.Save(m_presets.m_currentSlot);
+        }
+
+        if (m_field.KeyboardRisingEdge(8))
+        {
+            m_morph.CaptureA();
+        }
+
+        if (m_field.KeyboardRisingEdge(9))
+        {
+            m_morph.CaptureB();
+        }
+
+        if (m_field.KeyboardRisingEdge(10))
+        {
+            m_morph.RandomizeB();
+        }
+
+        if (m_field.KeyboardRisingEdge(11))
+        {
+            m_morph.Release();
+        }
+
+        if (m_field.KeyboardRisingEdge(12) && m_sdMounted)
+        {
+            m_recorder.Toggle();
+        }
+    }
+
+    // Called from the audio callback, once per block.
+    //
+    bool ProcessGate(size_t size)
+    {
+        uint64_t blockStart = m_gateInput.m_sampleTime;
+        bool edge = m_gateInput.Process(m_field.gate_in.State(), size);
+        if (m_midiBeat)
+        {
+            m_clock.Process(true, m_midiBeatTime, blockStart, size);
+        }
+        else
+        {
+            m_clock.Process(edge, m_gateInput.m_lastEdgeTime, blockStart, size);
+        }
+
+        return edge;
+    }
+
+    // Called from the audio callback, once per block, before ProcessGate.
+    // Stores CCs into their parameters, where everything that reads them
+    // hears them from this block on, and lists them with their offsets for
+    // the app. Counts clocks; the block's messages stay in m_midi for the
+    // app.
+    //
+    size_t ProcessMidi(size_t size)
+    {
+        size_t numEvents = m_midi.Collect(m_midi.Now(), size);
+        m_midiBeat = false;
+        m_numBlockRemotes = 0;
+        for (size_t i = 0; i < numEvents; i++)
+        {
+            const MidiEvent& event = m_midi.m_blockEvents[i];
+            switch (event.GetType())
+            {
+                case MidiEvent::ControlChange:
+                {
+                    size_t index = event.m_data1 - x_firstParamCc;
+                    size_t page = index / Parameter::x_numParameters;
+                    if (x_firstParamCc <= event.m_data1 && page < m_pageManager.m_numPages && m_pageManager.m_numLockedPages <= page)
+                    {
+                        uint8_t slot = index % Parameter::x_numParameters;
+                        m_pageManager.m_pages[page].m_parameters[slot].m_remoteValue.store(event.m_data2, std::memory_order_release);
+                        m_blockRemotes[m_numBlockRemotes++] = {static_cast<uint8_t>(page), slot, event.m_data2 / 127.0f, m_midi.m_blockOffsets[i]};
+                    }
+
+                    break;
+                }
+                case MidiEvent::Start:
+                {
+                    m_midiClocks = 0;
+                    break;
+                }
+                case MidiEvent::Clock:
+                {
+                    if (m_midiClocks++ % x_midiClocksPerBeat == 0)
+                    {
+                        m_midiBeat = true;
+                        m_midiBeatTime = m_gateInput.m_sampleTime + m_midi.m_blockOffsets[i];
+                    }
+
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+        }
+
+        return numEvents;
+    }
+
+#ifndef HOST_BUILD
+    static void MidiRxCallback(uint8_t* data, size_t size, void* context)
+    {
+        MidiInput* midi = static_cast<MidiInput*>(context);
+        midi->Receive(data, size, midi->Now());
+    }
+#endif
+
     void UpdateScreen()
     {
         m_field.display.Fill(0);
@@ -125,6 +336,11 @@ struct DaisyIO
                 buf[1] = '1' + m_pageManager.GetModIndex(row);
             }
 
+            if (row == 0 && m_recorder.IsRecording())
+            {
+                buf[2] = 'R';
+            }
+
             buf[3] = m_pageManager.TrackingBadge(row);
             buf[4] = '\0';
             m_field.display.WriteString(buf, Font_6x8, true);
@@ -155,9 +371,49 @@ struct DaisyIO
             m_pageManager.m_knobPositions[i] = m_field.knob[i].Process();
         }
 
-        m_gateTrigger.Reset(m_field.gate_in.State());
+        m_gateInput.Reset(m_field.gate_in.State());
 
         m_pageManager.Finalize();
+
+#ifdef HOST_BUILD
+        m_presets.m_flash.Init("presets.bin");
+#else
+        m_presets.m_flash.Init(&m_field.seed.qspi);
+#endif
+        m_presets.Init(&m_pageManager, &m_morph);
+
+        MountSd();
+
+#ifndef HOST_BUILD
+        // Trace lines go out over USB serial. Not waiting for a host means
+        // they are simply lost when nothing is listening.
+        //
+        m_field.seed.StartLog(false);
+
+        // The Field's own MIDI handler parses in the main loop and loses the
+        // arrival time, so the UART is driven directly and parsed in its
+        // interrupt.
+        //
+        daisy::MidiUartTransport::Config midiConfig;
+        m_midiTransport.Init(midiConfig);
+        m_midiTransport.StartRx(MidiRxCallback, &m_midi);
+#endif
+    }
+
+    // Files are read from the SD card root on the target and from the working
+    // directory on the host. No card just means m_sdMounted stays false.
+    //
+    void MountSd()
+    {
+#ifdef HOST_BUILD
+        m_sdMounted = true;
+#else
+        daisy::SdmmcHandler::Config sdConfig;
+        sdConfig.Defaults();
+        m_sdmmc.Init(sdConfig);
+        m_fatfs.Init(daisy::FatFSInterface::Config::MEDIA_SD);
+        m_sdMounted = f_mount(&m_fatfs.GetSDFileSystem(), "/", 1) == FR_OK;
+#endif
     }
 
     void MainLoop()
@@ -165,7 +421,22 @@ struct DaisyIO
         while (true)
         {
             ProcessControls();
+            m_presets.Poll();
+            m_morph.Poll();
+            m_recorder.Poll();
             UpdateScreen();
+#ifdef HOST_BUILD
+            Trace::Drain(Trace::PrintToFile, stdout);
+#else
+            Trace::Drain(PrintTraceLine, nullptr);
+#endif
         }
     }
+
+#ifndef HOST_BUILD
+    static void PrintTraceLine(void*, const char* line)
+    {
+        daisy::DaisySeed::PrintLine("%s", line);
+    }
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef HOST_BUILD
+#include "daisy_field.h"
+#endif
+
+// Control-rate work moved out of the audio interrupt. The audio callback
+// Post()s a request; PendSV, at the lowest priority, runs the job as soon as
+// the audio interrupt returns, so the job overlaps the time between blocks
+// rather than lengthening the callback. The job fills the back half of a
+// double buffer and publishes it; the next callback Acquire()s the newest
+// published frame. Controls therefore lag audio by one block.
+//
+// The writer (PendSV) can be preempted by the reader (audio) but never the
+// other way round, so two frames suffice: the reader only touches the
+// published frame and the writer only the other one.
+//
+// On the host there is no PendSV, so Post() runs the job on the spot. That
+// keeps the same one-block lag.
+//
+struct DeferredWorkDispatch
+{
+    static inline void (*s_run)(void* context) = nullptr;
+    static inline void* s_context = nullptr;
+};
+
+template<typename Frame>
+struct DeferredWork
+{
+    typedef void (*Job)(void* context, Frame* frame);
+
+    Frame m_frames[2];
+    Job m_job;
+    void* m_context;
+    volatile uint8_t m_published;
+    volatile uint32_t m_publishedSequence;
+    uint32_t m_consumedSequence;
+
+    DeferredWork()
+        : m_frames{}
+        , m_job(nullptr)
+        , m_context(nullptr)
+        , m_published(0)
+        , m_publishedSequence(0)
+        , m_consumedSequence(0)
+    {
+    }
+
+    // One DeferredWork per firmware: it owns the PendSV handler.
+    //
+    void Config(Job job, void* context)
+    {
+        m_job = job;
+        m_context = context;
+        DeferredWorkDispatch::s_context = this;
+        DeferredWorkDispatch::s_run = Dispatch;
+#ifndef HOST_BUILD
+        NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+#endif
+    }
+
+    bool HasFrame() const
+    {
+        return m_publishedSequence != 0;
+    }
+
+    // Audio callback. The newest frame not yet acquired, or nullptr.
+    //
+    const Frame* Acquire()
+    {
+        uint32_t sequence = m_publishedSequence;
+        if (sequence == m_consumedSequence)
+        {
+            return nullptr;
+        }
+
+        std::atomic_signal_fence(std::memory_order_acquire);
+        m_consumedSequence = sequence;
+        return &m_frames[m_published];
+    }
+
+    // Audio callback. Ask for the next frame.
+    //
+    void Post()
+    {
+#ifdef HOST_BUILD
+        Run();
+#else
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+    }
+
+    // Deferred context, or directly when a frame is needed before the first
+    // Post() has been served.
+    //
+    void Run()
+    {
+        uint8_t back = 1 - m_published;
+        m_job(m_context, &m_frames[back]);
+        std::atomic_signal_fence(std::memory_order_release);
+        m_published = back;
+        m_publishedSequence = m_publishedSequence + 1;
+    }
+
+    static void Dispatch(void* self)
+    {
+        static_cast<DeferredWork*>(self)->Run();
+    }
+};
+
+#ifndef HOST_BUILD
+// Apps are a single translation unit, so the handler is defined here.
+//
+extern "C" void PendSV_Handler()
+{
+    if (DeferredWorkDispatch::s_run)
+    {
+        DeferredWorkDispatch::s_run(DeferredWorkDispatch::s_context);
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Real FFT of a power-of-two length N, as a complex FFT of length N / 2 over
+// the even and odd samples plus one combining pass. Tables are built once in
+// the constructor, so construct it outside the audio callback.
+//
+// Spectra use the packed layout: [0] is the DC bin, [1] the Nyquist bin (both
+// real), then re, im pairs for bins 1 to N / 2 - 1. Neither direction is
+// scaled, so Inverse(Forward(x)) is N * x.
+//
+template<size_t N>
+struct RealFFT
+{
+    static constexpr size_t x_size = N;
+    static constexpr size_t x_half = N / 2;
+
+    static_assert(4 <= N && (N & (N - 1)) == 0, "RealFFT needs a power of two, at least 4");
+
+    // exp(-2 pi i k / N) for k < N / 2. The half-length complex FFT uses the
+    // even entries.
+    //
+    float m_cos[x_half];
+    float m_sin[x_half];
+    uint16_t m_bitReverse[x_half];
+
+    RealFFT()
+    {
+        for (size_t k = 0; k < x_half; k++)
+        {
+            double phase = -2.0 * M_PI * k / N;
+            m_cos[k] = static_cast<float>(std::cos(phase));
+            m_sin[k] = static_cast<float>(std::sin(phase));
+        }
+
+        size_t bits = 0;
+        while ((size_t(1) << bits) < x_half)
+        {
+            bits++;
+        }
+
+        for (size_t i = 0; i < x_half; i++)
+        {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; b++)
+            {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+
+            m_bitReverse[i] = static_cast<uint16_t>(reversed);
+        }
+    }
+
+    // In-place radix-2 FFT of N / 2 interleaved complex values. Inverse
+    // conjugates the twiddles.
+    //
+    void Complex(float* data, bool inverse) const
+    {
+        for (size_t i = 0; i < x_half; i++)
+        {
+            size_t j = m_bitReverse[i];
+            if (i < j)
+            {
+                std::swap(data[2 * i], data[2 * j]);
+                std::swap(data[2 * i + 1], data[2 * j + 1]);
+            }
+        }
+
+        float sign = inverse ? -1.0f : 1.0f;
+        for (size_t length = 2; length <= x_half; length *= 2)
+        {
+            size_t half = length / 2;
+            size_t stride = N / length;
+            for (size_t start = 0; start < x_half; start += length)
+            {
+                for (size_t k = 0; k < half; k++)
+                {
+                    float wr = m_cos[k * stride];
+                    float wi = sign * m_sin[k * stride];
+                    float* a = data + 2 * (start + k);
+                    float* b = data + 2 * (start + k + half);
+                    float br = b[0] * wr - b[1] * wi;
+                    float bi = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - br;
+                    b[1] = a[1] - bi;
+                    a[0] += br;
+                    a[1] += bi;
+                }
+            }
+        }
+    }
+
+    // in and out may be the same buffer.
+    //
+    void Forward(const float* in, float* out) const
+    {
+        if (in != out)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                out[i] = in[i];
+            }
+        }
+
+        Complex(out, false);
+
+        // X[k] = E[k] + W^k O[k], where E[k] = (Z[k] + conj(Z[M - k])) / 2 and
+        // O[k] = (Z[k] - conj(Z[M - k])) / 2i. Bins k and M - k are done
+        // together.
+        //
+        float z0r = out[0];
+        float z0i = out[1];
+        out[0] = z0r + z0i;
+        out[1] = z0r - z0i;
+
+        for (size_t k = 1; k <= x_half / 2; k++)
+        {
+            size_t m = x_half - k;
+            float ar = out[2 * k];
+            float ai = out[2 * k + 1];
+            float br = out[2 * m];
+            float bi = out[2 * m + 1];
+
+            float er = 0.5f * (ar + br);
+            float ei = 0.5f * (ai - bi);
+            float or_ = 0.5f * (ai + bi);
+            float oi = -0.5f * (ar - br);
+
+            float wr = m_cos[k];
+            float wi = m_sin[k];
+            float tr = wr * or_ - wi * oi;
+            float ti = wr * oi + wi * or_;
+
+            out[2 * k] = er + tr;
+            out[2 * k + 1] = ei + ti;
+
+            // X[M - k] = conj(E[k]) - conj(W^k O[k]).
+            //
+            out[2 * m] = er - tr;
+            out[2 * m + 1] = -(ei - ti);
+        }
+    }
+
+    void Inverse(const float* in, float* out) const
+    {
+        if (in != out)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                out[i] = in[i];
+            }
+        }
+
+        // Undo the combining pass: E[k] = X[k] + conj(X[M - k]) and
+        // O[k] = (X[k] - conj(X[M - k])) W^-k, then Z[k] = E[k] + i O[k].
+        // Leaving out the halves makes the whole inverse scale by N.
+        //
+        float dc = out[0];
+        float nyquist = out[1];
+        out[0] = dc + nyquist;
+        out[1] = dc - nyquist;
+
+        for (size_t k = 1; k <= x_half / 2; k++)
+        {
+            size_t m = x_half - k;
+            float ar = out[2 * k];
+            float ai = out[2 * k + 1];
+            float br = out[2 * m];
+            float bi = out[2 * m + 1];
+
+            float er = ar + br;
+            float ei = ai - bi;
+            float dr = ar - br;
+            float di = ai + bi;
+
+            float wr = m_cos[k];
+            float wi = -m_sin[k];
+            float or_ = dr * wr - di * wi;
+            float oi = dr * wi + di * wr;
+
+            out[2 * k] = er - oi;
+            out[2 * k + 1] = ei + or_;
+
+            // Z[M - k] = conj(E[k]) + i conj(O[k]).
+            //
+            out[2 * m] = er + oi;
+            out[2 * m + 1] = -ei + or_;
+        }
+
+        Complex(out, true);
+    }
+
+    // acc += a * b, bin by bin, in the packed layout.
+    //
+    static void MultiplyAdd(const float* a, const float* b, float* acc)
+    {
+        acc[0] += a[0] * b[0];
+        acc[1] += a[1] * b[1];
+        for (size_t i = 2; i < N; i += 2)
+        {
+            acc[i] += a[i] * b[i] - a[i + 1] * b[i + 1];
+            acc[i + 1] += a[i] * b[i + 1] + a[i + 1] * b[i];
+        }
+    }
+};
\ No newline at end of file
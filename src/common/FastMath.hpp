@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Approximations of the transcendental functions used per sample, in three
+// tiers picked at compile time:
+//
+//   Reference   <cmath>, the baseline
+//   Balanced    1e-4 (Tanh) to 1e-6 relative error, a few multiplies
+//   Fast        about 1e-3 to 1e-2 error, as cheap as it gets
+//
+// Sin2Pi takes its argument in cycles, like WaveTable::Evaluate. Exp2 and
+// Log2 assume finite arguments (Log2 a positive one). FastMathReport in
+// src/FastMathReport prints the measured error and speed of every tier.
+//
+enum class MathTier : uint8_t
+{
+    Reference = 0,
+    Balanced = 1,
+    Fast = 2,
+};
+
+template<MathTier Tier>
+struct FastMath
+{
+    static constexpr float x_twoPi = 6.28318530718f;
+    static constexpr float x_log2e = 1.44269504089f;
+    static constexpr float x_ln2 = 0.69314718056f;
+
+    // Exact for |x| < 2^31, no branch and no library call.
+    //
+    static float Floor(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::floor(x);
+        }
+        else
+        {
+            float truncated = static_cast<float>(static_cast<int32_t>(x));
+            return truncated - (x < truncated ? 1.0f : 0.0f);
+        }
+    }
+
+    static float Tanh(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::tanh(x);
+        }
+        else if constexpr (Tier == MathTier::Balanced)
+        {
+            // [7/6] Pade approximant, which reaches 1 at the clamp.
+            //
+            x = std::min(std::max(x, -4.97f), 4.97f);
+            float x2 = x * x;
+            float numerator = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+            float denominator = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+            return numerator / denominator;
+        }
+        else
+        {
+            x = std::min(std::max(x, -3.0f), 3.0f);
+            float x2 = x * x;
+            return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+        }
+    }
+
+    // 2^x = 2^n * 2^f with n = round(x) built straight into the exponent bits
+    // and |f| <= 0.5 from a polynomial.
+    //
+    static float Exp2(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::exp2(x);
+        }
+        else
+        {
+            x = std::min(std::max(x, -126.0f), 126.0f);
+            float n = Floor(x + 0.5f);
+            float f = x - n;
+            float p;
+            if constexpr (Tier == MathTier::Balanced)
+            {
+                p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * 0.00133335581f))));
+            }
+            else
+            {
+                p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * 0.0555041087f));
+            }
+
+            uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+            float scale;
+            memcpy(&scale, &bits, sizeof(scale));
+            return p * scale;
+        }
+    }
+
+    // log2(x) = e + log2(m), with m folded into [sqrt(1/2), sqrt(2)) and
+    // log2(m) from the atanh series in t = (m - 1) / (m + 1).
+    //
+    static float Log2(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::log2(x);
+        }
+        else
+        {
+            uint32_t bits;
+            memcpy(&bits, &x, sizeof(bits));
+            int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+            bits = (bits & 0x007FFFFF) | 0x3F800000;
+            float m;
+            memcpy(&m, &bits, sizeof(m));
+
+            bool fold = 1.41421356f < m;
+            m = fold ? m * 0.5f : m;
+            exponent += fold ? 1 : 0;
+
+            float t = (m - 1.0f) / (m + 1.0f);
+            float t2 = t * t;
+            float series;
+            if constexpr (Tier == MathTier::Balanced)
+            {
+                series = t * (1.0f + t2 * (0.333333333f + t2 * (0.2f + t2 * 0.142857143f)));
+            }
+            else
+            {
+                series = t * (1.0f + t2 * 0.333333333f);
+            }
+
+            return static_cast<float>(exponent) + 2.0f * x_log2e * series;
+        }
+    }
+
+    static float Exp(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::exp(x);
+        }
+        else
+        {
+            return Exp2(x * x_log2e);
+        }
+    }
+
+    static float Pow(float base, float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::pow(base, x);
+        }
+        else
+        {
+            return Exp2(x * Log2(base));
+        }
+    }
+
+    // log(cosh(x)), the antiderivative of tanh, written so it cannot
+    // overflow for large |x|.
+    //
+    static float LogCosh(float x)
+    {
+        x = std::abs(x);
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return x + std::log1p(std::exp(-2.0f * x)) - x_ln2;
+        }
+        else
+        {
+            return x + x_ln2 * (Log2(1.0f + Exp2(-2.0f * x_log2e * x)) - 1.0f);
+        }
+    }
+
+    // sin(2 pi x), x in cycles.
+    //
+    static float Sin2Pi(float x)
+    {
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return std::sin(x_twoPi * x);
+        }
+        else if constexpr (Tier == MathTier::Balanced)
+        {
+            // Wrap to [-0.5, 0.5), fold to [-0.25, 0.25] by symmetry about the
+            // peaks, then an odd degree-9 polynomial.
+            //
+            x -= Floor(x + 0.5f);
+            x = 0.25f < x ? 0.5f - x : (x < -0.25f ? -0.5f - x : x);
+            float z = x_twoPi * x;
+            float z2 = z * z;
+            return z * (1.0f + z2 * (-0.166666667f + z2 * (0.00833333333f + z2 * (-0.000198412698f + z2 * 2.75573192e-6f))));
+        }
+        else
+        {
+            // Parabola plus one correction step.
+            //
+            x -= Floor(x + 0.5f);
+            float y = 8.0f * x - 16.0f * x * std::abs(x);
+            return y + 0.225f * (y * std::abs(y) - y);
+        }
+    }
+};
\ No newline at end of file
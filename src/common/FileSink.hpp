@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef HOST_BUILD
+#include <cstdio>
+#else
+#include "daisy_field.h"
+#endif
+
+// A file created for writing: stdio on the host, FatFS on the SD card on the
+// target. The write side of FileSource. Main loop only.
+//
+struct FileSink
+{
+#ifdef HOST_BUILD
+    FILE* m_file;
+#else
+    FIL m_file;
+#endif
+    bool m_open;
+
+    FileSink()
+        : m_open(false)
+    {
+    }
+
+    ~FileSink()
+    {
+        Close();
+    }
+
+    // Replaces any existing file.
+    //
+    bool Open(const char* path)
+    {
+        Close();
+#ifdef HOST_BUILD
+        m_file = fopen(path, "wb");
+        m_open = m_file != nullptr;
+#else
+        m_open = f_open(&m_file, path, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK;
+#endif
+        return m_open;
+    }
+
+    bool Write(const void* data, size_t size)
+    {
+        if (!m_open)
+        {
+            return false;
+        }
+
+#ifdef HOST_BUILD
+        return fwrite(data, 1, size, m_file) == size;
+#else
+        UINT written = 0;
+        return f_write(&m_file, data, size, &written) == FR_OK && written == size;
+#endif
+    }
+
+    bool Seek(size_t position)
+    {
+        if (!m_open)
+        {
+            return false;
+        }
+
+#ifdef HOST_BUILD
+        return fseek(m_file, position, SEEK_SET) == 0;
+#else
+        return f_lseek(&m_file, position) == FR_OK;
+#endif
+    }
+
+    // Pushes cached data and the directory entry to the card, so a file cut
+    // off by power loss still holds everything up to here.
+    //
+    void Sync()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+#ifdef HOST_BUILD
+        fflush(m_file);
+#else
+        f_sync(&m_file);
+#endif
+    }
+
+    void Close()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+#ifdef HOST_BUILD
+        fclose(m_file);
+#else
+        f_close(&m_file);
+#endif
+        m_open = false;
+    }
+};
\ No newline at end of file
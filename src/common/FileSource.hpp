@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef HOST_BUILD
+#include <cstdio>
+#else
+#include "daisy_field.h"
+#endif
+
+// A file opened for reading, as a Source for WavFormat: stdio on the host,
+// FatFS on the SD card on the target (DaisyIO mounts it). Main loop only.
+//
+struct FileSource
+{
+#ifdef HOST_BUILD
+    FILE* m_file;
+#else
+    FIL m_file;
+#endif
+    bool m_open;
+
+    FileSource()
+        : m_open(false)
+    {
+    }
+
+    ~FileSource()
+    {
+        Close();
+    }
+
+    bool Open(const char* path)
+    {
+        Close();
+#ifdef HOST_BUILD
+        m_file = fopen(path, "rb");
+        m_open = m_file != nullptr;
+#else
+        m_open = f_open(&m_file, path, FA_READ) == FR_OK;
+#endif
+        return m_open;
+    }
+
+    bool Read(void* dst, size_t size)
+    {
+        if (!m_open)
+        {
+            return false;
+        }
+
+#ifdef HOST_BUILD
+        return fread(dst, 1, size, m_file) == size;
+#else
+        UINT bytesRead = 0;
+        return f_read(&m_file, dst, size, &bytesRead) == FR_OK && bytesRead == size;
+#endif
+    }
+
+    void Skip(size_t size)
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+#ifdef HOST_BUILD
+        fseek(m_file, size, SEEK_CUR);
+#else
+        f_lseek(&m_file, f_tell(&m_file) + size);
+#endif
+    }
+
+    void Close()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+#ifdef HOST_BUILD
+        fclose(m_file);
+#else
+        f_close(&m_file);
+#endif
+        m_open = false;
+    }
+};
\ No newline at end of file
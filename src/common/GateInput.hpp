@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SchmidtTrigger.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Gate input polled from the audio callback rather than the control loop.
+// The pin is read once per block, so an edge is stamped with the sample time
+// of the block it is seen in and acts from that block's first sample: the
+// resolution is one block.
+//
+struct GateInput
+{
+    SchmidtTrigger m_trigger;
+    uint64_t m_sampleTime;
+    uint64_t m_lastEdgeTime;
+
+    GateInput()
+        : m_trigger(0.2f, 0.1f)
+        , m_sampleTime(0)
+        , m_lastEdgeTime(0)
+    {
+    }
+
+    bool Process(bool state, size_t size)
+    {
+        bool risingEdge = m_trigger.Process(state ? 1.0f : 0.0f);
+        if (risingEdge)
+        {
+            m_lastEdgeTime = m_sampleTime;
+        }
+
+        m_sampleTime += size;
+        return risingEdge;
+    }
+
+    bool State() const
+    {
+        return m_trigger.m_state;
+    }
+
+    void Reset(bool state)
+    {
+        m_trigger.Reset(state ? 1.0f : 0.0f);
+    }
+};
\ No newline at end of file
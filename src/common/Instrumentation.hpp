@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Event counters bumped from the audio callback and read from the main loop
+// or a host tool. Relaxed atomics: counts only, no ordering.
+//
+struct Instrumentation
+{
+    enum class Counter : uint8_t
+    {
+        NonFiniteReset = 0,
+        SilentBlock = 1,
+        DriveCoefRecompute = 2,
+        RecorderOverrun = 3,
+        NumCounters = 4,
+    };
+
+    static constexpr size_t x_numCounters = static_cast<size_t>(Counter::NumCounters);
+
+    static inline const char* x_names[x_numCounters] =
+    {
+        "NonFiniteReset",
+        "SilentBlock",
+        "DriveCoefRecompute",
+        "RecorderOverrun",
+    };
+
+    static inline std::atomic<uint32_t> s_counters[x_numCounters] = {};
+
+    static void Count(Counter counter)
+    {
+        s_counters[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static uint32_t Get(Counter counter)
+    {
+        return s_counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    static const char* GetName(Counter counter)
+    {
+        return x_names[static_cast<size_t>(counter)];
+    }
+};
@@ -0,0 +1,409 @@
+#pragma once
+
+#include "AudioPipeline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef HOST_BUILD
+#include <memory>
+#else
+#include "daisy_field.h"
+#endif
+
+// Mono looper over a buffer of nearly three minutes in SDRAM. One press of
+// Record starts the first pass, the next closes the loop and plays it, and
+// further presses toggle overdub; Stop stops, and Stop again clears.
+//
+// Up to x_numHeads read heads play the loop, spread evenly around it by
+// SetSpread and all moving at the varispeed rate (SetSpeed), backwards when
+// reversed. Overdub writes at unit speed from where the first head was when
+// it started, so at speeds other than 1 the new layer lands against the
+// transposed playback.
+//
+// SDRAM is slow to reach sample by sample, so every access is a burst per
+// block: each head copies the span it will cover this block (at most
+// x_maxSpeed * block + 2 samples) into SRAM and interpolates from there, and
+// overdub reads, mixes and writes back its span in one pass each.
+//
+struct Looper
+{
+    static constexpr size_t x_maxSamples = size_t(1) << 23;
+    static constexpr size_t x_numHeads = 3;
+    static constexpr float x_maxSpeed = 4.0f;
+    static constexpr size_t x_windowSize = static_cast<size_t>(x_maxSpeed) * AudioPipeline::x_maxBlockSize + 2;
+    static constexpr float x_fadeStep = 1.0f / 480;
+
+    enum class State : uint8_t
+    {
+        Empty,
+        Recording,
+        Playing,
+        Overdubbing,
+        Stopped,
+    };
+
+    struct Storage
+    {
+        float m_buffer[x_maxSamples];
+    };
+
+    Storage* m_storage;
+#ifdef HOST_BUILD
+    std::unique_ptr<Storage> m_hostStorage;
+#endif
+
+    State m_state;
+    size_t m_length;
+    size_t m_writePos;
+    double m_readPos;
+    bool m_reverse;
+
+    float m_speed;
+    float m_level;
+    float m_feedback;
+    float m_spread;
+    size_t m_numHeads;
+
+    float m_gain;
+    bool m_finite;
+    float m_window[x_windowSize];
+    float m_scratch[AudioPipeline::x_maxBlockSize];
+
+    Looper()
+        : m_storage(nullptr)
+        , m_state(State::Empty)
+        , m_length(0)
+        , m_writePos(0)
+        , m_readPos(0.0)
+        , m_reverse(false)
+        , m_speed(1.0f)
+        , m_level(1.0f)
+        , m_feedback(1.0f)
+        , m_spread(0.5f)
+        , m_numHeads(1)
+        , m_gain(0.0f)
+        , m_finite(true)
+        , m_window{}
+        , m_scratch{}
+    {
+#ifdef HOST_BUILD
+        // On the host the storage is a heap block, zero-filled on allocation.
+        // Take that hit here rather than in the block that first records.
+        //
+        GetStorage();
+#endif
+    }
+
+    // One looper per firmware on the target: there is one SDRAM block.
+    //
+    Storage* GetStorage()
+    {
+        if (!m_storage)
+        {
+#ifdef HOST_BUILD
+            m_hostStorage.reset(new Storage());
+            m_storage = m_hostStorage.get();
+#else
+            static Storage s_storage DSY_SDRAM_BSS;
+            m_storage = &s_storage;
+#endif
+        }
+
+        return m_storage;
+    }
+
+    // Transport, from the audio callback at the top of a block.
+    //
+    void Record()
+    {
+        switch (m_state)
+        {
+            case State::Empty:
+            {
+                GetStorage();
+                m_state = State::Recording;
+                m_writePos = 0;
+                break;
+            }
+            case State::Recording:
+            {
+                CloseLoop();
+                break;
+            }
+            case State::Playing:
+            {
+                m_state = State::Overdubbing;
+                m_writePos = static_cast<size_t>(m_readPos) % m_length;
+                break;
+            }
+            case State::Overdubbing:
+            {
+                m_state = State::Playing;
+                break;
+            }
+            case State::Stopped:
+            {
+                m_state = State::Playing;
+                m_readPos = m_reverse ? m_length - 1 : 0.0;
+                break;
+            }
+        }
+    }
+
+    void Stop()
+    {
+        switch (m_state)
+        {
+            case State::Recording:
+            {
+                CloseLoop();
+                m_state = m_length ? State::Stopped : State::Empty;
+                break;
+            }
+            case State::Playing:
+            case State::Overdubbing:
+            {
+                m_state = State::Stopped;
+                break;
+            }
+            case State::Stopped:
+            {
+                Clear();
+                break;
+            }
+            case State::Empty:
+            {
+                break;
+            }
+        }
+    }
+
+    void Reverse()
+    {
+        m_reverse = !m_reverse;
+    }
+
+    void Clear()
+    {
+        m_state = State::Empty;
+        m_length = 0;
+        m_gain = 0.0f;
+    }
+
+    void CloseLoop()
+    {
+        m_length = m_writePos;
+        m_state = m_length ? State::Playing : State::Empty;
+        m_readPos = m_reverse && m_length ? m_length - 1 : 0.0;
+    }
+
+    // Playback rate, 1 / x_maxSpeed to x_maxSpeed. Snaps to 1 within 1% so the
+    // loop can be brought back to pitch by hand.
+    //
+    void SetSpeed(float speed)
+    {
+        m_speed = std::abs(speed - 1.0f) < 0.01f ? 1.0f : std::min(std::max(speed, 1.0f / x_maxSpeed), x_maxSpeed);
+    }
+
+    void SetLevel(float level)
+    {
+        m_level = level;
+    }
+
+    // How much of the loop survives each overdub pass.
+    //
+    void SetFeedback(float feedback)
+    {
+        m_feedback = feedback;
+    }
+
+    // 1 to x_numHeads over the knob.
+    //
+    void SetHeads(float knob)
+    {
+        m_numHeads = std::min(static_cast<size_t>(1 + knob * x_numHeads), x_numHeads);
+    }
+
+    // Offset between neighbouring heads, as a fraction of the loop over the
+    // number of heads: 1 spaces them evenly.
+    //
+    void SetSpread(float spread)
+    {
+        m_spread = spread;
+    }
+
+    bool IsSounding() const
+    {
+        return m_state == State::Recording || m_state == State::Playing || m_state == State::Overdubbing || m_gain != 0.0f;
+    }
+
+    // count samples of the loop from start (any integer) into dst, wrapping.
+    //
+    void Fetch(int64_t start, size_t count, float* dst) const
+    {
+        const float* buffer = m_storage->m_buffer;
+        size_t pos = static_cast<size_t>(((start % static_cast<int64_t>(m_length)) + m_length) % m_length);
+        while (count)
+        {
+            size_t n = std::min(count, m_length - pos);
+            memcpy(dst, buffer + pos, n * sizeof(float));
+            dst += n;
+            count -= n;
+            pos = 0;
+        }
+    }
+
+    void Store(int64_t start, size_t count, const float* src)
+    {
+        float* buffer = m_storage->m_buffer;
+        size_t pos = static_cast<size_t>(((start % static_cast<int64_t>(m_length)) + m_length) % m_length);
+        while (count)
+        {
+            size_t n = std::min(count, m_length - pos);
+            memcpy(buffer + pos, src, n * sizeof(float));
+            src += n;
+            count -= n;
+            pos = 0;
+        }
+    }
+
+    // Adds one head's block to output, at gain.
+    //
+    void ReadHead(double start, double step, float gain, float* output, size_t size)
+    {
+        double end = start + step * (size - 1);
+        int64_t low = static_cast<int64_t>(std::floor(std::min(start, end)));
+        size_t count = static_cast<size_t>(std::floor(std::max(start, end))) - low + 2;
+        Fetch(low, count, m_window);
+
+        float offset = static_cast<float>(start - low);
+        float delta = static_cast<float>(step);
+        for (size_t i = 0; i < size; i++)
+        {
+            float position = offset + delta * i;
+            size_t index = static_cast<size_t>(position);
+            float frac = position - index;
+            float a = m_window[index];
+            output[i] += gain * (a + frac * (m_window[index + 1] - a));
+        }
+    }
+
+    // Overdub over the block's span, in play direction at unit speed.
+    //
+    void WriteOverdub(const float* input, size_t size)
+    {
+        int64_t start = m_reverse ? static_cast<int64_t>(m_writePos) - static_cast<int64_t>(size - 1) : m_writePos;
+        Fetch(start, size, m_scratch);
+        for (size_t i = 0; i < size; i++)
+        {
+            size_t index = m_reverse ? size - 1 - i : i;
+            m_scratch[index] = m_feedback * m_scratch[index] + input[i];
+        }
+
+        m_finite = Scrub(m_scratch, size) && m_finite;
+        Store(start, size, m_scratch);
+        m_writePos = static_cast<size_t>(((m_reverse ? start - 1 : start + static_cast<int64_t>(size)) % static_cast<int64_t>(m_length) + m_length) % m_length);
+    }
+
+    // Records from source and adds the loop into output. They may be the same
+    // buffer: the source is taken before anything is added.
+    //
+    void ProcessBlock(const float* source, float* output, size_t size)
+    {
+        if (m_state == State::Recording)
+        {
+            size_t n = std::min(size, x_maxSamples - m_writePos);
+            memcpy(m_storage->m_buffer + m_writePos, source, n * sizeof(float));
+            m_finite = Scrub(m_storage->m_buffer + m_writePos, n) && m_finite;
+            m_writePos += n;
+            if (m_writePos == x_maxSamples)
+            {
+                CloseLoop();
+            }
+        }
+
+        if (source != output)
+        {
+            memcpy(output, source, size * sizeof(float));
+        }
+
+        bool playing = m_state == State::Playing || m_state == State::Overdubbing;
+        if (!playing && m_gain == 0.0f)
+        {
+            return;
+        }
+
+        // Written before the heads add to output, which may be the source.
+        // The new layer is heard on the next pass.
+        //
+        if (m_state == State::Overdubbing)
+        {
+            WriteOverdub(source, size);
+        }
+
+        float target = playing ? 1.0f : 0.0f;
+        float gain = m_gain;
+        for (size_t i = 0; i < size; i++)
+        {
+            gain += std::min(std::max(target - gain, -x_fadeStep), x_fadeStep);
+            m_scratch[i] = gain;
+        }
+
+        m_gain = gain;
+
+        float headGain = m_level / std::sqrt(static_cast<float>(m_numHeads));
+        double step = m_reverse ? -m_speed : m_speed;
+        double spacing = static_cast<double>(m_spread) * m_length / m_numHeads;
+        float mixed[AudioPipeline::x_maxBlockSize] = {};
+        for (size_t head = 0; head < m_numHeads; head++)
+        {
+            ReadHead(m_readPos + head * spacing, step, headGain, mixed, size);
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            output[i] += m_scratch[i] * mixed[i];
+        }
+
+        m_readPos = std::fmod(m_readPos + step * size, static_cast<double>(m_length));
+        if (m_readPos < 0.0)
+        {
+            m_readPos += m_length;
+        }
+    }
+
+    // Zeroes non-finite samples on their way into the loop, where they would
+    // replay forever. False if there were any.
+    //
+    static bool Scrub(float* samples, size_t size)
+    {
+        bool finite = true;
+        for (size_t i = 0; i < size; i++)
+        {
+            if (!std::isfinite(samples[i]))
+            {
+                samples[i] = 0.0f;
+                finite = false;
+            }
+        }
+
+        return finite;
+    }
+
+    // Only what the looper writes counts: the dry signal it passes through is
+    // the upstream stage's to guard. Nothing non-finite reaches the loop, so
+    // the recording is kept.
+    //
+    bool IsFinite() const
+    {
+        return m_finite;
+    }
+
+    void Reset()
+    {
+        m_finite = true;
+    }
+};
\ No newline at end of file
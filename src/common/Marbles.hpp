@@ -92,11 +92,38 @@ struct Marbles
         }
     }
  
-    void Process()
+    // Runs the output slew for a whole block, stepping on the given sample.
+    // Pass stepOffset >= size for a block without a step.
+    //
+    void ProcessBlock(size_t size, size_t stepOffset)
     {
+        UpdateParams();
+
+        size_t preStep = std::min(stepOffset, size);
         for (size_t i = 0; i < 2; i++)
         {
-            *m_output[i] = m_filter[i].Process(m_marbles[i][m_index[i]]);
+            SlewBlock(i, preStep);
+        }
+
+        if (stepOffset < size)
+        {
+            Increment();
+            for (size_t i = 0; i < 2; i++)
+            {
+                SlewBlock(i, size - preStep);
+            }
+        }
+    }
+
+    void SlewBlock(size_t i, size_t numSamples)
+    {
+        float target = m_marbles[i][m_index[i]];
+        float output = *m_output[i];
+        for (size_t j = 0; j < numSamples; j++)
+        {
+            output = m_filter[i].Process(target);
         }
+
+        *m_output[i] = output;
     }
 };
\ No newline at end of file
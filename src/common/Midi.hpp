@@ -0,0 +1,257 @@
+#pragma once
+
+#include "SpscRing.hpp"
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdint>
+
+#ifndef HOST_BUILD
+#include "daisy_field.h"
+#endif
+
+struct MidiEvent
+{
+    enum Type : uint8_t
+    {
+        NoteOff = 0x80,
+        NoteOn = 0x90,
+        PolyPressure = 0xA0,
+        ControlChange = 0xB0,
+        ProgramChange = 0xC0,
+        ChannelPressure = 0xD0,
+        PitchBend = 0xE0,
+        Clock = 0xF8,
+        Start = 0xFA,
+        Continue = 0xFB,
+        Stop = 0xFC,
+    };
+
+    uint32_t m_time;
+    uint8_t m_status;
+    uint8_t m_data1;
+    uint8_t m_data2;
+
+    // The message type without the channel, for channel messages.
+    //
+    uint8_t GetType() const
+    {
+        return m_status < 0xF0 ? m_status & 0xF0 : m_status;
+    }
+
+    uint8_t GetChannel() const
+    {
+        return m_status & 0x0F;
+    }
+
+    // A note-on with velocity 0 is a note-off.
+    //
+    bool IsNoteOn() const
+    {
+        return GetType() == NoteOn && m_data2 != 0;
+    }
+
+    bool IsNoteOff() const
+    {
+        return GetType() == NoteOff || (GetType() == NoteOn && m_data2 == 0);
+    }
+};
+
+// Byte stream to messages, with running status. Real-time bytes (clock,
+// start, stop) come out the moment they arrive, even between the bytes of
+// another message. SysEx and anything unknown is skipped.
+//
+struct MidiParser
+{
+    uint8_t m_status;
+    uint8_t m_data[2];
+    uint8_t m_count;
+
+    MidiParser()
+        : m_status(0)
+        , m_data{}
+        , m_count(0)
+    {
+    }
+
+    static uint8_t DataBytes(uint8_t status)
+    {
+        switch (status & 0xF0)
+        {
+            case 0xC0:
+            case 0xD0:
+            {
+                return 1;
+            }
+            case 0xF0:
+            {
+                return status == 0xF2 ? 2 : (status == 0xF1 || status == 0xF3) ? 1 : 0;
+            }
+            default:
+            {
+                return 2;
+            }
+        }
+    }
+
+    bool Parse(uint8_t byte, MidiEvent* event)
+    {
+        if (0xF8 <= byte)
+        {
+            event->m_status = byte;
+            event->m_data1 = 0;
+            event->m_data2 = 0;
+            return true;
+        }
+
+        if (byte & 0x80)
+        {
+            // A new status, or the end of (or a status inside) SysEx, which
+            // leaves nothing to run on.
+            //
+            m_status = byte == 0xF0 || byte == 0xF7 ? 0 : byte;
+            m_count = 0;
+            if (m_status != 0 && DataBytes(m_status) == 0)
+            {
+                event->m_status = m_status;
+                event->m_data1 = 0;
+                event->m_data2 = 0;
+                m_status = 0;
+                return true;
+            }
+
+            return false;
+        }
+
+        if (m_status == 0)
+        {
+            return false;
+        }
+
+        m_data[m_count++] = byte;
+        if (m_count < DataBytes(m_status))
+        {
+            return false;
+        }
+
+        event->m_status = m_status;
+        event->m_data1 = m_data[0];
+        event->m_data2 = m_count == 2 ? m_data[1] : 0;
+        m_count = 0;
+
+        // System common messages do not set running status.
+        //
+        if (0xF0 <= m_status)
+        {
+            m_status = 0;
+        }
+
+        return true;
+    }
+};
+
+// MIDI in. Receive() runs in the UART interrupt on the target (or wherever a
+// host tool feeds bytes), parses and timestamps messages and queues them
+// without locking. Collect() runs at the top of each audio block and takes
+// the messages that arrived during the previous block, each with its sample
+// offset: its position within the previous block, mapped onto this one. Every
+// message is therefore late by exactly one block, with no jitter.
+//
+// Times are in any free-running unit (microseconds on the target, sample
+// frames on the host), as long as Receive and Collect agree.
+//
+struct MidiInput
+{
+    static constexpr size_t x_queueSize = 256;
+    static constexpr size_t x_maxBlockEvents = 32;
+
+    SpscRing<MidiEvent, x_queueSize> m_queue;
+    MidiEvent m_storage[x_queueSize];
+    MidiParser m_parser;
+
+    MidiEvent m_blockEvents[x_maxBlockEvents];
+    size_t m_blockOffsets[x_maxBlockEvents];
+    size_t m_numBlockEvents;
+
+    uint32_t m_blockStart;
+    bool m_started;
+    uint32_t m_dropped;
+
+#ifdef HOST_BUILD
+    uint32_t m_hostNow;
+#endif
+
+    MidiInput()
+        : m_numBlockEvents(0)
+        , m_blockStart(0)
+        , m_started(false)
+        , m_dropped(0)
+#ifdef HOST_BUILD
+        , m_hostNow(0)
+#endif
+    {
+        m_queue.Init(m_storage);
+    }
+
+    uint32_t Now() const
+    {
+#ifdef HOST_BUILD
+        return m_hostNow;
+#else
+        return daisy::System::GetUs();
+#endif
+    }
+
+    // Producer side. A full queue drops the message.
+    //
+    void Receive(const uint8_t* data, size_t size, uint32_t time)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            MidiEvent event;
+            if (m_parser.Parse(data[i], &event))
+            {
+                event.m_time = time;
+                if (!m_queue.Write(&event, 1))
+                {
+                    m_dropped++;
+                    Trace::Emit(Trace::Event::MidiDrop, event.m_status, m_dropped);
+                }
+            }
+        }
+    }
+
+    // Consumer side, once per block. Messages stamped at or after now stay
+    // queued for the next block, as do any past x_maxBlockEvents.
+    //
+    size_t Collect(uint32_t now, size_t size)
+    {
+        m_numBlockEvents = 0;
+        uint32_t span = now - m_blockStart;
+        bool started = m_started;
+        m_blockStart = now;
+        m_started = true;
+
+        while (m_numBlockEvents < x_maxBlockEvents)
+        {
+            const MidiEvent* event;
+            if (m_queue.Peek(&event) == 0 || 0 <= static_cast<int32_t>(event->m_time - now))
+            {
+                break;
+            }
+
+            uint32_t age = now - event->m_time;
+            size_t offset = 0;
+            if (started && age < span)
+            {
+                offset = static_cast<size_t>(static_cast<uint64_t>(span - age) * size / span);
+            }
+
+            m_blockEvents[m_numBlockEvents] = *event;
+            m_blockOffsets[m_numBlockEvents] = offset < size ? offset : size - 1;
+            m_numBlockEvents++;
+            m_queue.Consume(1);
+        }
+
+        return m_numBlockEvents;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "Page.hpp"
+#include "PresetSnapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+// Interpolates every knob value and mod amount between two snapshots, A and
+// B. The parameters of the app's pages are flattened into one array of lanes
+// (knob values first, then mod amounts) so a block costs one lerp loop the
+// compiler can vectorize, followed by a scatter back into the parameters.
+//
+// Mod amounts whose source differs between A and B are stored negated on the
+// B side. The lerped lane then crosses zero on the way, which is where the mod
+// source switches over, so the route changes without a jump.
+//
+// Driven from the MRPH knob (or whatever mod is routed to it), or by a timed
+// fade, which is how preset recall crossfades. The fade starts from its own
+// snapshot, so a recall leaves the captured A and B alone. While either
+// runs, the knobs are locked out of the morphed pages.
+//
+struct MorphEngine
+{
+    static constexpr size_t x_numParams = PresetSnapshot::x_numParams;
+    static constexpr size_t x_numLanes = 2 * x_numParams;
+
+    enum class Mode : uint8_t
+    {
+        Off = 0,
+        Knob = 1,
+        Fade = 2,
+    };
+
+    PageManager* m_pageManager;
+    Page* m_page;
+    size_t m_numParams;
+
+    PresetSnapshot m_a;
+    PresetSnapshot m_b;
+    bool m_hasA;
+    bool m_hasB;
+    PresetSnapshot m_fadeFrom;
+
+    float m_base[x_numLanes];
+    float m_delta[x_numLanes];
+    float m_out[x_numLanes];
+    Parameter* m_params[x_numParams];
+    uint8_t m_modIndexA[x_numParams];
+    uint8_t m_modIndexB[x_numParams];
+
+    volatile Mode m_mode;
+    float m_fadeIncrement;
+    float m_fadePosition;
+    volatile bool m_fadeDone;
+    RGen m_rgen;
+
+    MorphEngine()
+        : m_pageManager(nullptr)
+        , m_page(nullptr)
+        , m_numParams(0)
+        , m_hasA(false)
+        , m_hasB(false)
+        , m_base{}
+        , m_delta{}
+        , m_out{}
+        , m_params{}
+        , m_mode(Mode::Off)
+        , m_fadeIncrement(0.0f)
+        , m_fadePosition(0.0f)
+        , m_fadeDone(false)
+    {
+    }
+
+    // Call after the app has added its pages; the morph page goes last and is
+    // itself excluded from morphing.
+    //
+    void Config(PageManager* pageManager)
+    {
+        m_pageManager = pageManager;
+        m_numParams = pageManager->m_numPages * Parameter::x_numParameters;
+        m_page = pageManager->AddPage();
+        m_page->InitParam("MRPH", 0, 0.0f);
+        m_page->m_parameters[0].m_randomize = false;
+
+        for (size_t i = 0; i < m_numParams; i++)
+        {
+            m_params[i] = PresetSnapshot::GetParameter(pageManager, i);
+        }
+    }
+
+    bool IsActive() const
+    {
+        return m_mode != Mode::Off;
+    }
+
+    // Main loop. Rebuilds the lanes from a and b. The audio side is parked
+    // first, since it preempts us and must not see half-written lanes.
+    //
+    void Prepare(const PresetSnapshot& a, const PresetSnapshot& b)
+    {
+        for (size_t i = 0; i < m_numParams; i++)
+        {
+            m_base[i] = a.m_knobValue[i];
+            m_delta[i] = b.m_knobValue[i] - a.m_knobValue[i];
+
+            m_modIndexA[i] = a.m_modIndex[i];
+            m_modIndexB[i] = b.m_modIndex[i];
+            float modA = a.m_modAmount[i];
+            float modB = a.m_modIndex[i] == b.m_modIndex[i] ? b.m_modAmount[i] : -b.m_modAmount[i];
+            m_base[m_numParams + i] = modA;
+            m_delta[m_numParams + i] = modB - modA;
+        }
+    }
+
+    void Engage(Mode mode)
+    {
+        // Knobs must not fight the morph: the morphed pages are locked and
+        // the visible one shows as not picked up until release.
+        //
+        m_pageManager->m_numLockedPages = static_cast<uint8_t>(m_numParams / Parameter::x_numParameters);
+        for (size_t i = 0; i < Parameter::x_numParameters; i++)
+        {
+            m_pageManager->m_pages[m_pageManager->m_currentPage].PageDeSelectParameter(i, m_pageManager->m_knobPositions[i]);
+        }
+
+        m_mode = mode;
+    }
+
+    // Main loop. Stops the morph, leaving the parameters where it put them,
+    // and hands the pages back to the knobs, which pick up again.
+    //
+    void Release()
+    {
+        m_mode = Mode::Off;
+        if (m_pageManager->m_numLockedPages)
+        {
+            m_pageManager->m_numLockedPages = 0;
+            m_pageManager->SelectPage(m_pageManager->m_currentPage);
+        }
+    }
+
+    void CaptureA()
+    {
+        Release();
+        m_a.Capture(m_pageManager);
+        m_hasA = true;
+        StartKnobMorph();
+    }
+
+    void CaptureB()
+    {
+        Release();
+        m_b.Capture(m_pageManager);
+        m_hasB = true;
+        StartKnobMorph();
+    }
+
+    // Fill B with a random patch the same way PageManager::RandomizeAllPages
+    // would, without touching the live parameters.
+    //
+    void RandomizeB()
+    {
+        Release();
+        if (!m_hasA)
+        {
+            m_a.Capture(m_pageManager);
+            m_hasA = true;
+        }
+
+        m_b = m_a;
+        for (size_t i = 0; i < m_numParams; i++)
+        {
+            if (m_params[i]->m_randomize)
+            {
+                m_b.m_knobValue[i] = m_rgen.UniGenRange(0, 1.0f);
+            }
+        }
+
+        m_hasB = true;
+        StartKnobMorph();
+    }
+
+    void StartKnobMorph()
+    {
+        if (m_hasA && m_hasB)
+        {
+            Prepare(m_a, m_b);
+            Engage(Mode::Knob);
+        }
+    }
+
+    // Main loop. Crossfade from the live patch to target over numBlocks.
+    //
+    void StartFade(const PresetSnapshot& target, size_t numBlocks)
+    {
+        m_mode = Mode::Off;
+        m_fadeFrom.Capture(m_pageManager);
+        Prepare(m_fadeFrom, target);
+        m_fadePosition = 0.0f;
+        m_fadeIncrement = 1.0f / numBlocks;
+        Engage(Mode::Fade);
+    }
+
+    // Audio callback, once per block.
+    //
+    void ProcessBlock()
+    {
+        float t;
+        switch (m_mode)
+        {
+            case Mode::Off:
+            {
+                return;
+            }
+            case Mode::Knob:
+            {
+                t = m_page->GetParam(0);
+                break;
+            }
+            case Mode::Fade:
+            default:
+            {
+                m_fadePosition = std::min(m_fadePosition + m_fadeIncrement, 1.0f);
+                t = m_fadePosition;
+                break;
+            }
+        }
+
+        size_t numLanes = 2 * m_numParams;
+        for (size_t i = 0; i < numLanes; i++)
+        {
+            m_out[i] = m_base[i] + t * m_delta[i];
+        }
+
+        for (size_t i = 0; i < m_numParams; i++)
+        {
+            float mod = m_out[m_numParams + i];
+            m_params[i]->m_knobValue = m_out[i];
+            m_params[i]->m_modAmount = std::abs(mod);
+            m_params[i]->m_modIndex = mod < 0.0f ? m_modIndexB[i] : m_modIndexA[i];
+        }
+
+        if (m_mode == Mode::Fade && 1.0f <= m_fadePosition)
+        {
+            m_mode = Mode::Off;
+            m_fadeDone = true;
+        }
+    }
+
+    // Main loop. Finishes a fade once the audio side is done with it.
+    //
+    void Poll()
+    {
+        if (m_fadeDone)
+        {
+            m_fadeDone = false;
+            Release();
+        }
+    }
+};
\ No newline at end of file
@@ -24,6 +24,11 @@ struct Page
         return m_parameters[position].Get(m_modMgr);
     }
 
+    float GetParam(uint8_t position, float knobValue)
+    {
+        return m_parameters[position].Get(knobValue, m_modMgr);
+    }
+
     bool IsTracking(uint8_t position)
     {
         return m_parameters[position].IsTracking();
@@ -47,6 +52,7 @@ struct Page
     void SetFuegoization()
     {
         m_parameters[Parameter::x_numParameters - 1].Init("FUEG", m_pageId, Parameter::x_numParameters - 1, 0.0f);
+        m_parameters[Parameter::x_numParameters - 1].m_randomize = false;
         for (size_t i = 0; i < Parameter::x_numParameters - 1; i++)
         {
             m_parameters[i].m_fuegoizationKnob = &m_parameters[Parameter::x_numParameters - 1];
@@ -75,6 +81,12 @@ struct PageManager
     uint8_t m_currentPage;
     ModMgr m_modMgr;
     uint8_t m_modIndex;
+
+    // Pages below this one belong to the morph engine while it runs: the
+    // knobs still move m_knobPositions but leave the parameters alone, so
+    // pickup cannot grab a value the morph is writing.
+    //
+    uint8_t m_numLockedPages;
     
     void StartModTracking(int modIndex)
     {
@@ -101,6 +113,7 @@ struct PageManager
         m_numPages = 0;
         m_currentPage = 0;
         m_modIndex = 255;
+        m_numLockedPages = 0;
         for (size_t i = 0; i < x_numPages; i++)
         {
             m_pages[i].m_modMgr = &m_modMgr;
@@ -154,9 +167,19 @@ struct PageManager
         }
     }
 
+    void RemoteSet(uint8_t page, uint8_t position, float value)
+    {
+        m_pages[page].m_parameters[position].RemoteSet(value, m_knobPositions[position]);
+    }
+
     void KnobUpdate(uint8_t position, float knobPosition)
     {
         m_knobPositions[position] = knobPosition;
+        if (m_currentPage < m_numLockedPages)
+        {
+            return;
+        }
+
         m_pages[m_currentPage].KnobUpdate(position, knobPosition, m_modIndex);
     }
 
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "Page.hpp"
+#include "ParamTable.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// One row of an app's parameter schema: where the knob lives, its default,
+// how the knob maps to a DSP value, whether that value is smoothed per sample
+// or applied once per block, and where it goes.
+//
+// Curves get the knob plus all knob values of its page, for curves that
+// depend on a neighbour (e.g. a cutoff that tracks a frequency).
+//
+template<typename Owner>
+struct ParamSpec
+{
+    typedef float (*Curve)(float knob, const float* pageKnobs);
+    typedef void (*Apply)(Owner* owner, float value);
+
+    enum class Smoothing : uint8_t
+    {
+        Block = 0,
+        OnePole = 1,
+    };
+
+    const char* m_name;
+    uint8_t m_page;
+    uint8_t m_slot;
+    float m_default;
+    Curve m_curve;
+    Smoothing m_smoothing;
+    Apply m_apply;
+};
+
+// Adapts a plain float(float) mapping, such as ParamTable::Lookup, to a curve.
+//
+template<float (*Map)(float)>
+float ParamCurve(float knob, const float*)
+{
+    return Map(knob);
+}
+
+inline float IdentityCurve(float knob, const float*)
+{
+    return knob;
+}
+
+// For static_asserts over a table: every row names its knob, maps it and has
+// somewhere to put the result.
+//
+template<typename Owner, size_t N>
+constexpr bool ParamSpecsComplete(const ParamSpec<Owner> (&specs)[N])
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (!specs[i].m_name || !specs[i].m_curve || !specs[i].m_apply)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// For static_asserts on rows an app addresses by index.
+//
+template<typename Owner>
+constexpr bool ParamSpecNamed(const ParamSpec<Owner>& spec, const char* name)
+{
+    size_t i = 0;
+    for (; spec.m_name[i] && spec.m_name[i] == name[i]; i++)
+    {
+    }
+
+    return spec.m_name[i] == name[i];
+}
+
+// Drives a table of ParamSpecs. Config registers every row with its page,
+// ReadBlock maps knobs to targets once per block (or ComputeFrame does it
+// elsewhere and ApplyFrame hands the result over), and Smooth runs all one-pole
+// smoothers in one loop per sample, calling setters only for values that are
+// still moving. Block-rate rows are applied from ReadBlock, and only when
+// their value changed.
+//
+// Remote knob moves (MIDI CCs) come in between frames: ScheduleRemote queues
+// one at its sample offset and ApplyRemotes, run per sample ahead of Smooth,
+// retargets its page's rows from that sample. The next frames already read
+// the same value through Parameter::Get, so nothing jumps back.
+//
+// A row can be overridden with a target from elsewhere (a tempo-synced
+// time, say). Frames and remotes then leave it alone, and releasing it
+// retargets it at its knob, so both switches glide through the smoother.
+//
+// Knob reads move by less than x_knobEpsilon (one step of the 12-bit ADC)
+// are dropped, so ADC noise on an idle knob leaves its target bit-for-bit
+// unchanged and nothing downstream is recomputed.
+//
+template<typename Owner, size_t N, size_t NumPages>
+struct ParamSchema
+{
+    typedef ParamSpec<Owner> Spec;
+
+    // Same response as RuntimeParam: a one-pole at 1kHz.
+    //
+    static constexpr float x_alpha = 1.0 - ConstMath::Exp(-2.0 * ConstMath::x_pi * 1000.0 / 48000.0);
+    static constexpr float x_settleEpsilon = 1e-5f;
+    static constexpr float x_settleFloor = 1e-9f;
+    static constexpr float x_knobEpsilon = 1.0f / 4096;
+    static constexpr size_t x_maxRemotes = 32;
+
+    struct Remote
+    {
+        uint8_t m_page;
+        uint8_t m_slot;
+        float m_knob;
+        size_t m_offset;
+    };
+
+    const Spec* m_specs;
+    Page* m_pages[NumPages];
+    float m_knobs[NumPages][Parameter::x_numParameters];
+    float m_heldKnobs[NumPages][Parameter::x_numParameters];
+    bool m_heldValid;
+    float m_target[N];
+    float m_value[N];
+    bool m_moving[N];
+    bool m_overridden[N];
+    bool m_first;
+    Remote m_remotes[x_maxRemotes];
+    size_t m_numRemotes;
+    size_t m_nextRemote;
+
+    ParamSchema()
+        : m_specs(nullptr)
+        , m_pages{}
+        , m_knobs{}
+        , m_heldKnobs{}
+        , m_heldValid(false)
+        , m_target{}
+        , m_value{}
+        , m_moving{}
+        , m_overridden{}
+        , m_first(true)
+        , m_remotes{}
+        , m_numRemotes(0)
+        , m_nextRemote(0)
+    {
+    }
+
+    void Config(const Spec* specs, Page* const* pages)
+    {
+        m_specs = specs;
+        for (size_t i = 0; i < NumPages; i++)
+        {
+            m_pages[i] = pages[i];
+        }
+
+        for (size_t i = 0; i < N; i++)
+        {
+            m_pages[m_specs[i].m_page]->InitParam(m_specs[i].m_name, m_specs[i].m_slot, m_specs[i].m_default);
+        }
+    }
+
+    float GetKnob(size_t page, size_t slot) const
+    {
+        return m_knobs[page][slot];
+    }
+
+    // Everything ReadBlock computes, without touching any DSP state, so it can
+    // be produced outside the audio callback.
+    //
+    struct Frame
+    {
+        float m_knobs[NumPages][Parameter::x_numParameters];
+        float m_target[N];
+    };
+
+    // Small moves are dropped against the last accepted read, not the last
+    // read, so a slow sweep still gets through once it adds up to a step.
+    // The ends of the range are always accepted.
+    //
+    float HoldKnob(size_t page, size_t slot, float knob)
+    {
+        float held = m_heldKnobs[page][slot];
+        if (m_heldValid && std::abs(knob - held) < x_knobEpsilon && knob != 0.0f && knob != 1.0f)
+        {
+            return held;
+        }
+
+        m_heldKnobs[page][slot] = knob;
+        return knob;
+    }
+
+    // Not reentrant: the held knobs belong to whichever context computes
+    // frames.
+    //
+    void ComputeFrame(Frame* frame)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            uint8_t page = m_specs[i].m_page;
+            uint8_t slot = m_specs[i].m_slot;
+            frame->m_knobs[page][slot] = HoldKnob(page, slot, m_pages[page]->GetParam(slot));
+        }
+
+        m_heldValid = true;
+
+        for (size_t i = 0; i < N; i++)
+        {
+            const Spec& spec = m_specs[i];
+            frame->m_target[i] = spec.m_curve(frame->m_knobs[spec.m_page][spec.m_slot], frame->m_knobs[spec.m_page]);
+        }
+    }
+
+    void SetTarget(Owner* owner, size_t index, float target)
+    {
+        m_target[index] = target;
+        if (m_specs[index].m_smoothing == Spec::Smoothing::Block)
+        {
+            m_value[index] = target;
+            m_specs[index].m_apply(owner, target);
+        }
+        else
+        {
+            m_moving[index] = true;
+        }
+    }
+
+    void ApplyFrame(Owner* owner, const Frame& frame)
+    {
+        memcpy(m_knobs, frame.m_knobs, sizeof(m_knobs));
+        for (size_t i = 0; i < N; i++)
+        {
+            float target = frame.m_target[i];
+            if (m_overridden[i])
+            {
+                continue;
+            }
+
+            if (target != m_target[i] || m_first)
+            {
+                SetTarget(owner, i, target);
+            }
+        }
+
+        m_first = false;
+    }
+
+    // Audio callback, after the frame is applied. page is the PageManager
+    // index; pages this schema does not own are ignored. Offsets must not go
+    // backwards within a block.
+    //
+    void ScheduleRemote(uint8_t page, uint8_t slot, float value, size_t offset)
+    {
+        for (size_t i = 0; i < NumPages; i++)
+        {
+            if (m_pages[i]->m_pageId == page && m_numRemotes < x_maxRemotes)
+            {
+                m_remotes[m_numRemotes++] = {static_cast<uint8_t>(i), slot, m_pages[i]->GetParam(slot, value), offset};
+                return;
+            }
+        }
+    }
+
+    // Before Smooth at each sample, and with SIZE_MAX to flush what a
+    // skipped block left. Only the remote knob changes here: a curve that
+    // reads a neighbour retargets against the neighbour's last frame value.
+    //
+    void ApplyRemotes(Owner* owner, size_t sample)
+    {
+        if (m_nextRemote == m_numRemotes)
+        {
+            return;
+        }
+
+        while (m_nextRemote < m_numRemotes && m_remotes[m_nextRemote].m_offset <= sample)
+        {
+            const Remote& remote = m_remotes[m_nextRemote++];
+            const float* pageKnobs = m_knobs[remote.m_page];
+            m_knobs[remote.m_page][remote.m_slot] = remote.m_knob;
+            for (size_t i = 0; i < N; i++)
+            {
+                const Spec& spec = m_specs[i];
+                if (spec.m_page != remote.m_page || m_overridden[i])
+                {
+                    continue;
+                }
+
+                float target = spec.m_curve(pageKnobs[spec.m_slot], pageKnobs);
+                if (target != m_target[i])
+                {
+                    SetTarget(owner, i, target);
+                }
+            }
+        }
+
+        if (m_nextRemote == m_numRemotes)
+        {
+            m_numRemotes = 0;
+            m_nextRemote = 0;
+        }
+    }
+
+    void Override(Owner* owner, size_t index, float target)
+    {
+        m_overridden[index] = true;
+        if (target != m_target[index])
+        {
+            SetTarget(owner, index, target);
+        }
+    }
+
+    void ReleaseOverride(Owner* owner, size_t index)
+    {
+        if (!m_overridden[index])
+        {
+            return;
+        }
+
+        m_overridden[index] = false;
+        const Spec& spec = m_specs[index];
+        SetTarget(owner, index, spec.m_curve(m_knobs[spec.m_page][spec.m_slot], m_knobs[spec.m_page]));
+    }
+
+    void ReadBlock(Owner* owner)
+    {
+        Frame frame;
+        ComputeFrame(&frame);
+        ApplyFrame(owner, frame);
+    }
+
+    void Smooth(Owner* owner)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            m_value[i] += x_alpha * (m_target[i] - m_value[i]);
+        }
+
+        for (size_t i = 0; i < N; i++)
+        {
+            if (!m_moving[i])
+            {
+                continue;
+            }
+
+            if (std::abs(m_target[i] - m_value[i]) <= x_settleEpsilon * std::abs(m_target[i]) + x_settleFloor)
+            {
+                m_value[i] = m_target[i];
+                m_moving[i] = false;
+            }
+
+            m_specs[i].m_apply(owner, m_value[i]);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Enough of <cmath> to evaluate parameter curves at compile time.
+//
+struct ConstMath
+{
+    static constexpr double x_ln2 = 0.693147180559945309417;
+    static constexpr double x_pi = 3.14159265358979323846;
+
+    static constexpr double Exp(double x)
+    {
+        // exp(x) = 2^k * exp(r) with |r| <= ln2 / 2, then a Taylor series for exp(r).
+        //
+        int k = static_cast<int>(x / x_ln2 + (x < 0 ? -0.5 : 0.5));
+        double r = x - k * x_ln2;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int i = 1; i < 24; i++)
+        {
+            term *= r / i;
+            sum += term;
+        }
+
+        for (; 0 < k; k--)
+        {
+            sum *= 2.0;
+        }
+
+        for (; k < 0; k++)
+        {
+            sum *= 0.5;
+        }
+
+        return sum;
+    }
+
+    static constexpr double Log(double x)
+    {
+        // log(x) = k * ln2 + log(m) with m in [1, 2), then the atanh series for log(m).
+        //
+        int k = 0;
+        while (2.0 <= x)
+        {
+            x *= 0.5;
+            k++;
+        }
+
+        while (x < 1.0)
+        {
+            x *= 2.0;
+            k--;
+        }
+
+        double z = (x - 1.0) / (x + 1.0);
+        double z2 = z * z;
+        double term = z;
+        double sum = 0.0;
+        for (int i = 1; i < 60; i += 2)
+        {
+            sum += term / i;
+            term *= z2;
+        }
+
+        return k * x_ln2 + 2.0 * sum;
+    }
+
+    static constexpr double Pow(double base, double x)
+    {
+        return Exp(x * Log(base));
+    }
+};
+
+// Curves matching PhaseUtils::ExpParam and PhaseUtils::ZeroedExpParam. Range
+// is any type with constexpr x_min and x_max.
+//
+template<typename Range>
+struct ExpCurve
+{
+    static constexpr double Compute(double x)
+    {
+        return Range::x_min * ConstMath::Pow(Range::x_max / Range::x_min, x);
+    }
+};
+
+template<int Base>
+struct ZeroedExpCurve
+{
+    static constexpr double Compute(double x)
+    {
+        return (ConstMath::Pow(Base, x) - 1.0) / (Base - 1.0);
+    }
+};
+
+// One-pole lowpass coefficient for a natural frequency in cycles per sample,
+// as Froggers::Alpha computes it, over an exponential frequency range.
+//
+template<typename Range>
+struct AlphaCurve
+{
+    static constexpr double Compute(double x)
+    {
+        return 1.0 - ConstMath::Exp(-2.0 * ConstMath::x_pi * ExpCurve<Range>::Compute(x));
+    }
+};
+
+// Dense table of Curve::Compute over [0, 1], built at compile time. It lands
+// in .rodata, so on target it is read straight from flash. Lookup is a clamp,
+// two loads and a lerp.
+//
+template<typename Curve, size_t N = 256>
+struct ParamTable
+{
+    static constexpr size_t x_size = N;
+
+    struct Data
+    {
+        float m_values[N + 1];
+    };
+
+    static constexpr Data Generate()
+    {
+        Data data{};
+        for (size_t i = 0; i <= N; i++)
+        {
+            data.m_values[i] = static_cast<float>(Curve::Compute(static_cast<double>(i) / N));
+        }
+
+        return data;
+    }
+
+    static constexpr Data x_data = Generate();
+
+    static float Lookup(float x)
+    {
+        float position = std::min(std::max(x, 0.0f), 1.0f) * N;
+        size_t index = std::min(static_cast<size_t>(position), N - 1);
+        float frac = position - index;
+        float low = x_data.m_values[index];
+        return low + frac * (x_data.m_values[index + 1] - low);
+    }
+};
\ No newline at end of file
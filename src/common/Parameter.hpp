@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -35,6 +36,7 @@ struct Parameter
 {
     static constexpr size_t x_numParameters = 8;
     static constexpr float x_knobEpsilon = 0.001f;
+    static constexpr uint8_t x_noRemote = 0xFF;
 
     enum class TrackingState : uint8_t
     {
@@ -53,8 +55,15 @@ struct Parameter
     uint8_t m_modIndex;
     float m_modAmount;
     bool m_modTrackingArmed;
+    bool m_randomize;
     Parameter* m_fuegoizationKnob;
 
+    // A MIDI CC value (0 to 127) stored by the audio callback and read in
+    // place of m_knobValue until the main loop has taken it over through
+    // RemoteSet, or x_noRemote.
+    //
+    std::atomic<uint8_t> m_remoteValue;
+
     Parameter()
      : m_knobValue(0)
      , m_position(0)
@@ -64,7 +73,9 @@ struct Parameter
      , m_modIndex(255)
      , m_modAmount(0.0f)
      , m_modTrackingArmed(false)
+     , m_randomize(true)
      , m_fuegoizationKnob(nullptr)
+     , m_remoteValue(x_noRemote)
     {
     }
 
@@ -87,21 +98,35 @@ struct Parameter
         return m_name.m_name;
     }
 
-    float GetPreFuegoization(ModMgr* modMgr)
+    float GetKnobValue() const
+    {
+        uint8_t remote = m_remoteValue.load(std::memory_order_acquire);
+        return remote == x_noRemote ? m_knobValue : remote / 127.0f;
+    }
+
+    float GetPreFuegoization(float knobValue, ModMgr* modMgr)
     {
         if (m_modIndex != 255)
         {
-            return modMgr->Modulate(m_knobValue, m_modIndex, m_modAmount);
+            return modMgr->Modulate(knobValue, m_modIndex, m_modAmount);
         }
         else
         {
-            return m_knobValue;
+            return knobValue;
         }
     }
 
     float Get(ModMgr* modMgr)
     {
-        float value = GetPreFuegoization(modMgr);
+        return Get(GetKnobValue(), modMgr);
+    }
+
+    // The value for the knob at knobValue, with this parameter's modulation
+    // and fuegoization.
+    //
+    float Get(float knobValue, ModMgr* modMgr)
+    {
+        float value = GetPreFuegoization(knobValue, modMgr);
         if (m_fuegoizationKnob)
         {
             float fuegoizationAmount = m_fuegoizationKnob->Get(modMgr);
@@ -162,7 +187,7 @@ struct Parameter
 
     void Randomize(float currentKnobPosition)
     {
-        if (strcmp(m_name.m_name, "FUEG") == 0)
+        if (!m_randomize)
         {
             return;
         }
@@ -189,6 +214,18 @@ struct Parameter
         }
     }
 
+    // A value from somewhere other than the knob (MIDI). A knob that was
+    // tracking lets go until it reaches the new value, as after Randomize.
+    //
+    void RemoteSet(float value, float currentKnobPosition)
+    {
+        m_knobValue = value;
+        if (m_trackingState != TrackingState::Idle)
+        {
+            PageSelect(currentKnobPosition);
+        }
+    }
+
     void PageDeSelect(float knobValue)
     {
         StopModTracking(knobValue);
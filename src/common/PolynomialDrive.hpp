@@ -2,17 +2,31 @@
 
 #include "SmartGridInclude.hpp"
 #include "RuntimeParam.hpp"
+#include "ParamTable.hpp"
+#include "Q15.hpp"
+#include "FastMath.hpp"
+#include "StaticGraph.hpp"
+#include <algorithm>
 
 struct PolynomialDrive
 {
+    struct GainRange
+    {
+        static constexpr double x_min = 1.0;
+        static constexpr double x_max = 5.0;
+    };
+
+    using GainTable = ParamTable<ExpCurve<GainRange>>;
+    using ShapeTable = ParamTable<ZeroedExpCurve<30>>;
+
+    static constexpr size_t x_numCoefs = 5;
+
     RuntimeParam m_gain;
-    RuntimeParam m_coefs[5];
-    WaveTable const* m_sinTable;
+    RuntimeParam m_coefs[x_numCoefs];
 
     PolynomialDrive()
         : m_gain()
         , m_coefs{}
-        , m_sinTable(&WaveTable::GetSine())
     {
     }
 
@@ -25,16 +39,68 @@ struct PolynomialDrive
         return m_gain.Process() * (input * m_coefs[0].Process() + input2 * m_coefs[1].Process() + input3 * m_coefs[2].Process() + input4 * m_coefs[3].Process() + input5 * m_coefs[4].Process());
     }
 
+    // Advances the smoothed gain and coefficients one sample, as Process
+    // does, and returns the coefficients with the gain folded in.
+    //
+    void NextCoefs(float* coefs)
+    {
+        float gain = m_gain.Process();
+        for (size_t i = 0; i < x_numCoefs; i++)
+        {
+            coefs[i] = gain * m_coefs[i].Process();
+        }
+    }
+
+    // First-order antiderivative anti-aliasing: the mean of the polynomial
+    // P(x) = sum of c_k x^(k+1) over [prev, input], (F(input) - F(prev)) /
+    // (input - prev) with F its antiderivative. For a polynomial the division
+    // is exact, (x^(k+2) - y^(k+2)) / (x - y) = sum of x^j y^(k+1-j), so
+    // this needs no fallback when input and prev are close, and it is P(x)
+    // when they are equal.
+    //
+    static float Antiderivative(const float* coefs, float input, float prev)
+    {
+        float prevPower = 1.0f;
+        float sum = 1.0f;
+        float output = 0.0f;
+        for (size_t k = 0; k < x_numCoefs; k++)
+        {
+            prevPower *= prev;
+            sum = input * sum + prevPower;
+            output += coefs[k] * sum * (1.0f / (k + 2));
+        }
+
+        return output;
+    }
+
     void SetGain(float gain)
     {
-        float computedGain = PhaseUtils::ExpParam::Compute(1.0, 5.0, gain);
+        float computedGain = GainTable::Lookup(gain);
         m_gain.SetTarget(computedGain);
     }
 
     void SetCoefs(float coefsKnob)
     {
-        float computedGain = m_gain.m_target;
-        coefsKnob = PhaseUtils::ZeroedExpParam::Compute(30.0, coefsKnob);
+        float coefs[x_numCoefs];
+        ComputeCoefs(m_gain.m_target, coefsKnob, coefs);
+        SetCoefTargets(coefs);
+    }
+
+    void SetCoefTargets(const float* coefs)
+    {
+        for (size_t i = 0; i < x_numCoefs; i++)
+        {
+            m_coefs[i].SetTarget(coefs[i]);
+        }
+    }
+
+    // The coefficient design behind SetCoefs, free of any state so it can run
+    // outside the audio callback. computedGain is the mapped gain (1 to 5).
+    //
+    static void ComputeCoefs(float computedGain, float coefsKnob, float* coefs)
+    {
+        const WaveTable& sinTable = WaveTable::GetSine();
+        coefsKnob = ShapeTable::Lookup(coefsKnob);
 
         // Use a space-filling curve to map a single knob to 5 coefficients
         // Using sin/cos with different frequencies and phases to explore parameter space
@@ -42,34 +108,36 @@ struct PolynomialDrive
         float phase = coefsKnob;
         float phase0 = phase * 1.0f;
         phase0 = phase0 - std::floor(phase0);
-        m_coefs[0].SetTarget(1.0 + 10.0f * m_sinTable->Evaluate(phase0));
+        coefs[0] = 1.0 + 10.0f * sinTable.Evaluate(phase0);
 
         float phase1 = phase * 1.618f + 0.25f * (computedGain - 1);
         phase1 = phase1 - std::floor(phase1);
-        m_coefs[1].SetTarget(10.0f * m_sinTable->Evaluate(phase1));
+        coefs[1] = 10.0f * sinTable.Evaluate(phase1);
 
         float phase2 = phase * 2.718f;
         phase2 = phase2 - std::floor(phase2);
-        m_coefs[2].SetTarget(10.0f * m_sinTable->Evaluate(phase2));
+        coefs[2] = 10.0f * sinTable.Evaluate(phase2);
 
         float phase3 = phase * 3.141f + 0.25f * (computedGain - 1);
         phase3 = phase3 - std::floor(phase3);
-        m_coefs[3].SetTarget(10.0f * m_sinTable->Evaluate(phase3));
+        coefs[3] = 10.0f * sinTable.Evaluate(phase3);
 
         float phase4 = phase * 4.669f;
         phase4 = phase4 - std::floor(phase4);
-        m_coefs[4].SetTarget(10.0f * m_sinTable->Evaluate(phase4));
+        coefs[4] = 10.0f * sinTable.Evaluate(phase4);
     }
 };
 
 struct Oversampler2x
 {
     float m_prevInput;
+    float m_output;
     bool m_firstSample;
     OPLowPassFilter m_antiAlias;
 
     Oversampler2x()
         : m_prevInput(0.0f)
+        , m_output(0.0f)
         , m_firstSample(true)
         , m_antiAlias()
     {
@@ -114,8 +182,108 @@ struct Oversampler2x
         }
 
         m_prevInput = input;
+        m_output = output;
         return output;
     }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output) && std::isfinite(m_prevInput);
+    }
+
+    void Reset()
+    {
+        float alpha = m_antiAlias.m_alpha;
+        m_antiAlias = OPLowPassFilter();
+        m_antiAlias.m_alpha = alpha;
+        m_prevInput = 0.0f;
+        m_output = 0.0f;
+        m_firstSample = true;
+    }
+};
+
+// First-order antiderivative anti-aliasing for FrogBlock's shaper, at 1x
+// rate. The drive polynomial is averaged exactly over each input step, then
+// the sine fold and tanh are averaged over each step of the polynomial's
+// output. Each stage adds half a sample of delay, about what Oversampler2x's
+// filter adds.
+//
+// The sine fold's mean over [b, a] is sin(mid) times a sinc of the step, so
+// it is well conditioned everywhere. Tanh's mean divides a difference of
+// log-cosh values, so steps below x_epsilon fall back to tanh at the
+// midpoint.
+//
+template<MathTier Tier>
+struct Antiderivative1x
+{
+    typedef FastMath<Tier> Math;
+
+    static constexpr float x_epsilon = 1e-2f;
+    static constexpr float x_quarterPi = 0.785398163f;
+
+    float m_prevInput;
+    float m_prevDrive;
+    float m_prevLogCosh;
+    float m_output;
+
+    Antiderivative1x()
+        : m_prevInput(0.0f)
+        , m_prevDrive(0.0f)
+        , m_prevLogCosh(0.0f)
+        , m_output(0.0f)
+    {
+    }
+
+    // sin(t) / t.
+    //
+    static float Sinc(float t)
+    {
+        if (std::abs(t) < 1e-3f)
+        {
+            return 1.0f - t * t * (1.0f / 6);
+        }
+
+        return Math::Sin2Pi(t * (1.0f / Math::x_twoPi)) / t;
+    }
+
+    // sine takes cycles, like WaveTable::Evaluate, and the fold of drive
+    // output u is sine(u / 4). fuzz blends in tanh as in FrogBlock.
+    //
+    template<typename SineFunc>
+    float Process(float input, PolynomialDrive* drive, float fuzz, SineFunc sine)
+    {
+        float coefs[PolynomialDrive::x_numCoefs];
+        drive->NextCoefs(coefs);
+        float drive1 = PolynomialDrive::Antiderivative(coefs, input, m_prevInput);
+        m_prevInput = input;
+
+        float step = drive1 - m_prevDrive;
+        float mid = 0.5f * (drive1 + m_prevDrive);
+        float folded = sine(mid / 4) * Sinc(x_quarterPi * step);
+
+        float logCosh = Math::LogCosh(drive1);
+        float saturated = std::abs(step) < x_epsilon
+            ? Math::Tanh(mid)
+            : (logCosh - m_prevLogCosh) / step;
+
+        m_prevDrive = drive1;
+        m_prevLogCosh = logCosh;
+        m_output = folded * (1 - fuzz) + fuzz * saturated;
+        return m_output;
+    }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output) && std::isfinite(m_prevDrive) && std::isfinite(m_prevLogCosh);
+    }
+
+    void Reset()
+    {
+        m_prevInput = 0.0f;
+        m_prevDrive = 0.0f;
+        m_prevLogCosh = 0.0f;
+        m_output = 0.0f;
+    }
 };
 
 struct DigitalReorganizer
@@ -125,6 +293,7 @@ struct DigitalReorganizer
 
     DigitalReorganizer()
         : m_flip(0)
+        , m_hashBits(0)
     {
     }
 
@@ -156,20 +325,150 @@ struct DigitalReorganizer
     {
         m_hashBits = static_cast<uint8_t>(std::round(hashKnob * 8));
     }
+
+    bool IsNeutral() const
+    {
+        return m_flip == 0 && m_hashBits == 0;
+    }
+
+    // Q15 version of Process, two samples per word. Adding 128 to the
+    // offset-binary sample puts round(inputUp) in the high byte of each lane
+    // and the rounding remainder (plus 128) in the low byte, so the flip and
+    // hash act on the high bytes exactly as Process does on inputInt. The add
+    // saturates, so the top half step clamps to 255 where Process would
+    // overflow the uint8_t.
+    //
+    void ProcessBlock(int16_t* samples, size_t size)
+    {
+        uint32_t flip = static_cast<uint32_t>(m_flip) << 8;
+        flip |= flip << 16;
+        uint32_t mask = (((1u << m_hashBits) - 1) & 0xFF) << 8;
+        mask |= mask << 16;
+
+        for (size_t i = 0; i + 1 < size; i += 2)
+        {
+            Q15::Store2(samples + i, ProcessPair(Q15::Load2(samples + i), flip, mask));
+        }
+
+        if (size & 1)
+        {
+            uint32_t pair = static_cast<uint16_t>(samples[size - 1]);
+            samples[size - 1] = static_cast<int16_t>(ProcessPair(pair, flip, mask) & 0xFFFF);
+        }
+    }
+
+    static uint32_t ProcessPair(uint32_t pair, uint32_t flip, uint32_t mask)
+    {
+        uint32_t value = Q15::AddLanesSaturate(pair ^ 0x80008000, 0x00800080);
+        value ^= flip;
+
+        uint32_t lowerBits = value & mask;
+        lowerBits ^= (lowerBits << 3) & mask;
+        lowerBits ^= (lowerBits >> 5) & mask;
+        lowerBits ^= (lowerBits << 1) & mask;
+        value = (value & ~mask) | lowerBits;
+
+        return Q15::SubLanesSaturate(value, 0x00800080) ^ 0x80008000;
+    }
+};
+
+// The library SampleRateReducer on Q15 samples. The phase and its update
+// rule stay in float exactly as there, so a new sample is taken on the same
+// ticks and only the held value is fixed point. SetFreq ramps the rate
+// linearly across the next block, standing in for the per-sample smoothing
+// SRR1/SRR2 had before they went block rate.
+//
+struct SampleRateReducerQ15
+{
+    float m_phase;
+    float m_freq;
+    float m_targetFreq;
+    int16_t m_hold;
+
+    SampleRateReducerQ15()
+        : m_phase(0.0f)
+        , m_freq(1.0f)
+        , m_targetFreq(1.0f)
+        , m_hold(0)
+    {
+    }
+
+    // Hold rate in updates per sample; 1 and above passes every sample.
+    //
+    void SetFreq(float freq)
+    {
+        m_targetFreq = freq;
+    }
+
+    // Longest a held sample can last at the slower of the current and target
+    // rates.
+    //
+    size_t HoldSamples() const
+    {
+        float freq = std::max(std::min(m_freq, m_targetFreq), 1.0f / StageTail::x_maxSamples);
+        return std::min<size_t>(static_cast<size_t>(std::ceil(1.0f / freq)), StageTail::x_maxSamples);
+    }
+
+    // Passing every sample, and not ramping towards anything else.
+    //
+    bool IsNeutral() const
+    {
+        return m_freq >= 1.0f && m_targetFreq >= 1.0f;
+    }
+
+    void ProcessBlock(int16_t* samples, size_t size)
+    {
+        float step = (m_targetFreq - m_freq) / static_cast<float>(std::max<size_t>(size, 1));
+        for (size_t i = 0; i < size; i++)
+        {
+            m_freq += step;
+            m_phase += m_freq;
+            if (m_phase >= 1.0f)
+            {
+                m_phase -= 1.0f;
+                m_hold = samples[i];
+            }
+
+            samples[i] = m_hold;
+        }
+
+        m_freq = m_targetFreq;
+    }
 };
 
-struct FrogBlock
+// Tier picks how the oversampled shaper evaluates its floor, sine fold and
+// tanh: the sine table and TanhSaturator for Reference, FastMath otherwise.
+//
+template<MathTier Tier>
+struct BasicFrogBlock
 {
+    typedef FastMath<Tier> Math;
+
+    static constexpr size_t x_maxBlockSize = 48;
+
+    // How the shaper keeps its harmonics from aliasing: run it twice per
+    // sample and filter, or once per sample on antiderivatives.
+    //
+    enum class AntiAlias : uint8_t
+    {
+        Oversample2x = 0,
+        Antiderivative = 1,
+    };
+
     PolynomialDrive m_polynomialDrive;
     WaveTable const* m_sinTable;
     TanhSaturator<false> m_tanhSaturator;
-    SampleRateReducer m_sampleRateReducer1;
-    SampleRateReducer m_sampleRateReducer2;
+    SampleRateReducerQ15 m_sampleRateReducer1;
+    SampleRateReducerQ15 m_sampleRateReducer2;
     DigitalReorganizer m_digitalReorganizer;
     Oversampler2x m_oversampler;
+    Antiderivative1x<Tier> m_antiderivative;
+    AntiAlias m_antiAlias;
     float m_fuzz;
+    float m_fuzzValue;
+    int16_t m_digital[x_maxBlockSize];
 
-    FrogBlock()
+    BasicFrogBlock()
         : m_polynomialDrive()
         , m_sinTable(&WaveTable::GetSine())
         , m_tanhSaturator()
@@ -177,26 +476,173 @@ struct FrogBlock
         , m_sampleRateReducer2()
         , m_digitalReorganizer()
         , m_oversampler()
+        , m_antiderivative()
+        , m_antiAlias(AntiAlias::Oversample2x)
         , m_fuzz(0)
+        , m_fuzzValue(0)
+        , m_digital{}
     {
         m_tanhSaturator.SetInputGain(1.0f);
     }
 
-    float Process(float input)
+    // Switching starts the newly chosen path from rest, so it never resumes
+    // from state left over from the last time it ran.
+    //
+    void SetAntiAlias(float knob)
+    {
+        AntiAlias antiAlias = knob < 0.5f ? AntiAlias::Oversample2x : AntiAlias::Antiderivative;
+        if (antiAlias == m_antiAlias)
+        {
+            return;
+        }
+
+        m_antiAlias = antiAlias;
+        if (antiAlias == AntiAlias::Oversample2x)
+        {
+            m_oversampler.Reset();
+        }
+        else
+        {
+            m_antiderivative.Reset();
+        }
+    }
+
+    float Sine(float cycles)
+    {
+        cycles = cycles - Math::Floor(cycles);
+        if constexpr (Tier == MathTier::Reference)
+        {
+            return m_sinTable->Evaluate(cycles);
+        }
+        else
+        {
+            return Math::Sin2Pi(cycles);
+        }
+    }
+
+    // The drive runs in float, at 2x or on antiderivatives. The digital stages after it run as one
+    // Q15 segment, converted once on the way in and once on the way out.
+    // Fuzz ramps linearly across the block towards m_fuzz.
+    //
+    void ProcessBlock(const float* input, float* output, size_t size)
     {
-        // Process chain up to digital reorganizer with 2x oversampling
+        for (size_t offset = 0; offset < size; offset += x_maxBlockSize)
+        {
+            size_t chunk = std::min(x_maxBlockSize, size - offset);
+            ProcessChunk(input + offset, output + offset, chunk);
+        }
+    }
+
+    void ProcessChunk(const float* input, float* output, size_t size)
+    {
+        float fuzzStep = (m_fuzz - m_fuzzValue) / size;
+        if (m_antiAlias == AntiAlias::Antiderivative)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                m_fuzzValue += fuzzStep;
+                output[i] = m_antiderivative.Process(input[i], &m_polynomialDrive, m_fuzzValue, [this](float cycles)
+                {
+                    return Sine(cycles);
+                });
+            }
+        }
+        else
+        {
+            // With no fuzz the tanh term is exactly zero, so it is not
+            // evaluated at all.
+            //
+            bool fuzzOff = m_fuzz == 0.0f && m_fuzzValue == 0.0f;
+            for (size_t i = 0; i < size; i++)
+            {
+                m_fuzzValue += fuzzStep;
+                output[i] = m_oversampler.Process(input[i], [this, fuzzOff](float in) -> float
+                {
+                    float out = m_polynomialDrive.Process(in);
+                    float folded = Sine(out / 4);
+                    if (fuzzOff)
+                    {
+                        return folded;
+                    }
+
+                    if constexpr (Tier == MathTier::Reference)
+                    {
+                        return folded * (1 - m_fuzzValue) + m_fuzzValue * m_tanhSaturator.Process(out);
+                    }
+                    else
+                    {
+                        return folded * (1 - m_fuzzValue) + m_fuzzValue * Math::Tanh(out);
+                    }
+                });
+            }
+        }
+
+        m_fuzzValue = m_fuzz;
+
+        // Neutral digital stages are skipped, and with all three neutral so is
+        // the Q15 round trip. Each of them is an identity to within one Q15
+        // step when neutral, so no crossfade is needed.
         //
-        float output = m_oversampler.Process(input, [this](float in) -> float
+        bool reorganize = !m_digitalReorganizer.IsNeutral();
+        bool reduce1 = !m_sampleRateReducer1.IsNeutral();
+        bool reduce2 = !m_sampleRateReducer2.IsNeutral();
+        if (!reorganize && !reduce1 && !reduce2)
         {
-            float out = m_polynomialDrive.Process(in);
-            float sinIn = out / 4;
-            sinIn = sinIn - std::floor(sinIn);
-            return m_sinTable->Evaluate(sinIn) * (1 - m_fuzz) + m_fuzz * m_tanhSaturator.Process(out);
-        });
+            return;
+        }
 
-        output = m_digitalReorganizer.Process(output);
-        output = m_sampleRateReducer1.Process(output);
-        output = m_sampleRateReducer2.Process(output);
-        return output;
+        Q15::FromFloatBlock(output, m_digital, size);
+        if (reorganize)
+        {
+            m_digitalReorganizer.ProcessBlock(m_digital, size);
+        }
+
+        if (reduce1)
+        {
+            m_sampleRateReducer1.ProcessBlock(m_digital, size);
+        }
+
+        if (reduce2)
+        {
+            m_sampleRateReducer2.ProcessBlock(m_digital, size);
+        }
+
+        Q15::ToFloatBlock(m_digital, output, size);
+    }
+
+    // Silence in gives silence out once the anti-alias filter and any held
+    // samples have run out. A DIGR flip turns silence into a constant, which
+    // no tail covers; SilenceGate's output check catches that.
+    //
+    size_t TailSamples() const
+    {
+        size_t tail = StageTail::OnePole(m_oversampler.m_antiAlias.m_alpha);
+        if (!m_sampleRateReducer1.IsNeutral())
+        {
+            tail += m_sampleRateReducer1.HoldSamples();
+        }
+
+        if (!m_sampleRateReducer2.IsNeutral())
+        {
+            tail += m_sampleRateReducer2.HoldSamples();
+        }
+
+        return tail;
+    }
+
+    // The anti-alias paths are the only recursive state here; the Q15
+    // segment cannot carry a NaN.
+    //
+    bool IsFinite() const
+    {
+        return m_oversampler.IsFinite() && m_antiderivative.IsFinite();
     }
-};
\ No newline at end of file
+
+    void Reset()
+    {
+        m_oversampler.Reset();
+        m_antiderivative.Reset();
+    }
+};
+
+using FrogBlock = BasicFrogBlock<MathTier::Reference>;
\ No newline at end of file
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "Page.hpp"
+#include "PresetFlash.hpp"
+#include "PresetSnapshot.hpp"
+#include "Morph.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// On-flash layout of one preset. Knob values and mod amounts are stored as
+// 16-bit fixed point, which is finer than the knobs can resolve.
+//
+struct PresetRecord
+{
+    static constexpr uint32_t x_magic = 0x46524F47;
+    static constexpr uint16_t x_version = 2;
+    static constexpr size_t x_numParams = PresetSnapshot::x_numParams;
+
+    uint32_t m_magic;
+    uint16_t m_version;
+    uint8_t m_slot;
+    uint8_t m_reserved;
+    uint32_t m_sequence;
+    uint32_t m_checksum;
+    uint16_t m_knobValue[x_numParams];
+    uint16_t m_modAmount[x_numParams];
+    uint8_t m_modIndex[x_numParams];
+
+    static uint16_t Quantize(float value)
+    {
+        return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+    }
+
+    static float DeQuantize(uint16_t value)
+    {
+        return static_cast<float>(value) / 65535.0f;
+    }
+
+    static uint32_t Hash(uint32_t hash, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+
+    // FNV-1a over the whole record except the checksum field itself, so a
+    // flipped slot or sequence cannot move a record or let a stale one win.
+    //
+    uint32_t ComputeChecksum() const
+    {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(this);
+        const uint8_t* checksum = reinterpret_cast<const uint8_t*>(&m_checksum);
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(this + 1);
+        uint32_t hash = Hash(2166136261u, begin, checksum - begin);
+        return Hash(hash, checksum + sizeof(m_checksum), end - checksum - sizeof(m_checksum));
+    }
+
+    bool IsValid() const
+    {
+        return m_magic == x_magic && m_version == x_version && m_checksum == ComputeChecksum();
+    }
+
+    void Serialize(const PresetSnapshot& snapshot, uint8_t slot, uint32_t sequence)
+    {
+        memset(this, 0, sizeof(PresetRecord));
+        m_magic = x_magic;
+        m_version = x_version;
+        m_slot = slot;
+        m_sequence = sequence;
+        for (size_t i = 0; i < x_numParams; i++)
+        {
+            m_knobValue[i] = Quantize(snapshot.m_knobValue[i]);
+            m_modAmount[i] = Quantize(snapshot.m_modAmount[i]);
+            m_modIndex[i] = snapshot.m_modIndex[i];
+        }
+
+        m_checksum = ComputeChecksum();
+    }
+
+    void Deserialize(PresetSnapshot* snapshot) const
+    {
+        for (size_t i = 0; i < x_numParams; i++)
+        {
+            snapshot->m_knobValue[i] = DeQuantize(m_knobValue[i]);
+            snapshot->m_modAmount[i] = DeQuantize(m_modAmount[i]);
+            snapshot->m_modIndex[i] = m_modIndex[i] < ModMgr::x_numMods ? m_modIndex[i] : 255;
+        }
+    }
+};
+
+// Preset slots kept as a log in the flash region: every save goes to a fresh
+// sector, the newest valid record of a slot wins, and sectors holding a live
+// record are skipped when the log wraps. Saves are written from the main loop
+// one erase or page program per Poll(). Recall hands the stored patch to the
+// MorphEngine, which crossfades to it over a few audio blocks.
+//
+struct PresetManager
+{
+    static constexpr size_t x_numSlots = 8;
+    static constexpr size_t x_fadeBlocks = 32;
+    static constexpr uint16_t x_noSector = 0xFFFF;
+
+    static_assert(sizeof(PresetRecord) <= PresetFlash::x_sectorSize, "Preset record must fit in a sector");
+
+    enum class WriteState : uint8_t
+    {
+        Idle = 0,
+        Erase = 1,
+        Program = 2,
+        Commit = 3,
+    };
+
+    PresetFlash m_flash;
+    PageManager* m_pageManager;
+    MorphEngine* m_morph;
+
+    uint16_t m_slotSector[x_numSlots];
+    uint32_t m_slotSequence[x_numSlots];
+    uint32_t m_nextSequence;
+    uint16_t m_nextSector;
+    uint8_t m_currentSlot;
+
+    WriteState m_writeState;
+    uint16_t m_writeSector;
+    size_t m_writeOffset;
+    PresetRecord m_record;
+
+    PresetSnapshot m_snapshot;
+
+    PresetManager()
+        : m_pageManager(nullptr)
+        , m_morph(nullptr)
+        , m_nextSequence(1)
+        , m_nextSector(0)
+        , m_currentSlot(0)
+        , m_writeState(WriteState::Idle)
+        , m_writeSector(x_noSector)
+        , m_writeOffset(0)
+    {
+        for (size_t i = 0; i < x_numSlots; i++)
+        {
+            m_slotSector[i] = x_noSector;
+            m_slotSequence[i] = 0;
+        }
+    }
+
+    // Scan the log for the newest valid record of each slot.
+    //
+    void Init(PageManager* pageManager, MorphEngine* morph)
+    {
+        m_pageManager = pageManager;
+        m_morph = morph;
+        uint32_t newest = 0;
+        for (size_t sector = 0; sector < PresetFlash::x_numSectors; sector++)
+        {
+            m_flash.Read(sector * PresetFlash::x_sectorSize, &m_record, sizeof(PresetRecord));
+            if (!m_record.IsValid() || x_numSlots <= m_record.m_slot)
+            {
+                continue;
+            }
+
+            if (m_slotSector[m_record.m_slot] == x_noSector || m_slotSequence[m_record.m_slot] < m_record.m_sequence)
+            {
+                m_slotSector[m_record.m_slot] = sector;
+                m_slotSequence[m_record.m_slot] = m_record.m_sequence;
+            }
+
+            if (newest < m_record.m_sequence)
+            {
+                newest = m_record.m_sequence;
+                m_nextSector = (sector + 1) % PresetFlash::x_numSectors;
+            }
+        }
+
+        m_nextSequence = newest + 1;
+    }
+
+    bool HasSlot(uint8_t slot) const
+    {
+        return slot < x_numSlots && m_slotSector[slot] != x_noSector;
+    }
+
+    bool IsBusy() const
+    {
+        return m_writeState != WriteState::Idle || m_morph->m_mode == MorphEngine::Mode::Fade;
+    }
+
+    bool IsLive(uint16_t sector) const
+    {
+        for (size_t i = 0; i < x_numSlots; i++)
+        {
+            if (m_slotSector[i] == sector)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Main loop. Snapshot the current patch and queue it for writing.
+    //
+    bool Save(uint8_t slot)
+    {
+        if (x_numSlots <= slot || IsBusy())
+        {
+            return false;
+        }
+
+        m_snapshot.Capture(m_pageManager);
+        m_record.Serialize(m_snapshot, slot, m_nextSequence);
+
+        // At most x_numSlots sectors are live, so this always terminates.
+        //
+        while (IsLive(m_nextSector))
+        {
+            m_nextSector = (m_nextSector + 1) % PresetFlash::x_numSectors;
+        }
+
+        m_writeSector = m_nextSector;
+        m_writeOffset = 0;
+        m_writeState = WriteState::Erase;
+        m_currentSlot = slot;
+        return true;
+    }
+
+    // Main loop. Start a crossfade to the stored preset, picked up by the
+    // next audio block.
+    //
+    bool Recall(uint8_t slot)
+    {
+        if (!HasSlot(slot) || IsBusy())
+        {
+            return false;
+        }
+
+        m_flash.Read(m_slotSector[slot] * PresetFlash::x_sectorSize, &m_record, sizeof(PresetRecord));
+        if (!m_record.IsValid())
+        {
+            return false;
+        }
+
+        m_record.Deserialize(&m_snapshot);
+        m_morph->StartFade(m_snapshot, x_fadeBlocks);
+        m_currentSlot = slot;
+        return true;
+    }
+
+    // Main loop. Advances a pending write by one flash operation.
+    //
+    void Poll()
+    {
+        size_t sectorOffset = m_writeSector * PresetFlash::x_sectorSize;
+        switch (m_writeState)
+        {
+            case WriteState::Idle:
+            {
+                break;
+            }
+            case WriteState::Erase:
+            {
+                m_flash.EraseSector(sectorOffset);
+                m_writeState = WriteState::Program;
+                break;
+            }
+            case WriteState::Program:
+            {
+                size_t size = std::min(PresetFlash::x_pageSize, sizeof(PresetRecord) - m_writeOffset);
+                m_flash.WritePage(sectorOffset + m_writeOffset, reinterpret_cast<const uint8_t*>(&m_record) + m_writeOffset, size);
+                m_writeOffset += size;
+                if (sizeof(PresetRecord) <= m_writeOffset)
+                {
+                    m_writeState = WriteState::Commit;
+                }
+
+                break;
+            }
+            case WriteState::Commit:
+            {
+                uint8_t slot = m_record.m_slot;
+                uint32_t sequence = m_record.m_sequence;
+                m_flash.Read(sectorOffset, &m_record, sizeof(PresetRecord));
+                if (m_record.IsValid() && m_record.m_sequence == sequence)
+                {
+                    m_slotSector[slot] = m_writeSector;
+                    m_slotSequence[slot] = sequence;
+                    m_nextSequence++;
+                }
+
+                m_nextSector = (m_writeSector + 1) % PresetFlash::x_numSectors;
+                m_writeState = WriteState::Idle;
+                break;
+            }
+        }
+    }
+};
\ No newline at end of file
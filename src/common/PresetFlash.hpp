@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef HOST_BUILD
+#include <cstdio>
+#else
+#include "daisy_field.h"
+#endif
+
+// Raw access to the region of QSPI flash reserved for presets, at the very end
+// of the 8M part so it stays clear of anything the linker places in QSPIFLASH.
+// Offsets are relative to the start of the preset region.
+// On the host the region is emulated by a file with NOR semantics (erase sets
+// bytes to 0xFF, programming can only clear bits) so the preset code can be
+// exercised without hardware.
+//
+struct PresetFlash
+{
+    static constexpr size_t x_sectorSize = 4096;
+    static constexpr size_t x_pageSize = 256;
+    static constexpr size_t x_numSectors = 64;
+    static constexpr size_t x_regionSize = x_numSectors * x_sectorSize;
+    static constexpr uint32_t x_flashSize = 8 * 1024 * 1024;
+    static constexpr uint32_t x_baseOffset = x_flashSize - x_regionSize;
+
+#ifdef HOST_BUILD
+    FILE* m_file;
+
+    PresetFlash()
+        : m_file(nullptr)
+    {
+    }
+
+    ~PresetFlash()
+    {
+        if (m_file)
+        {
+            fclose(m_file);
+        }
+    }
+
+    bool Init(const char* path)
+    {
+        m_file = fopen(path, "r+b");
+        if (!m_file)
+        {
+            m_file = fopen(path, "w+b");
+            if (!m_file)
+            {
+                return false;
+            }
+
+            uint8_t erased[x_sectorSize];
+            memset(erased, 0xFF, x_sectorSize);
+            for (size_t i = 0; i < x_numSectors; i++)
+            {
+                fwrite(erased, 1, x_sectorSize, m_file);
+            }
+
+            fflush(m_file);
+        }
+
+        return true;
+    }
+
+    void Read(size_t offset, void* dst, size_t size)
+    {
+        fseek(m_file, offset, SEEK_SET);
+        if (fread(dst, 1, size, m_file) != size)
+        {
+            memset(dst, 0xFF, size);
+        }
+    }
+
+    void EraseSector(size_t offset)
+    {
+        uint8_t erased[x_sectorSize];
+        memset(erased, 0xFF, x_sectorSize);
+        fseek(m_file, offset - offset % x_sectorSize, SEEK_SET);
+        fwrite(erased, 1, x_sectorSize, m_file);
+        fflush(m_file);
+    }
+
+    void WritePage(size_t offset, const void* src, size_t size)
+    {
+        uint8_t current[x_pageSize];
+        Read(offset, current, size);
+        const uint8_t* bytes = static_cast<const uint8_t*>(src);
+        for (size_t i = 0; i < size; i++)
+        {
+            current[i] &= bytes[i];
+        }
+
+        fseek(m_file, offset, SEEK_SET);
+        fwrite(current, 1, size, m_file);
+        fflush(m_file);
+    }
+#else
+    daisy::QSPIHandle* m_qspi;
+
+    PresetFlash()
+        : m_qspi(nullptr)
+    {
+    }
+
+    bool Init(daisy::QSPIHandle* qspi)
+    {
+        m_qspi = qspi;
+        return true;
+    }
+
+    void Read(size_t offset, void* dst, size_t size)
+    {
+        memcpy(dst, m_qspi->GetData(x_baseOffset + offset), size);
+    }
+
+    void EraseSector(size_t offset)
+    {
+        m_qspi->EraseSector(x_baseOffset + offset - offset % x_sectorSize);
+        InvalidateCache(offset - offset % x_sectorSize, x_sectorSize);
+    }
+
+    void WritePage(size_t offset, const void* src, size_t size)
+    {
+        m_qspi->Write(x_baseOffset + offset, size, static_cast<uint8_t*>(const_cast<void*>(src)));
+        InvalidateCache(offset, size);
+    }
+
+    // The memory-mapped region is cached, so drop stale lines after the
+    // flash contents change underneath it.
+    //
+    void InvalidateCache(size_t offset, size_t size)
+    {
+        SCB_InvalidateDCache_by_Addr(static_cast<uint32_t*>(m_qspi->GetData(x_baseOffset + offset)), size);
+    }
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Page.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Flat copy of everything a patch consists of: knob value, mod source and mod
+// amount for every parameter slot of every page. Fuegoization is the last
+// knob of each page, so it comes along for free.
+//
+struct PresetSnapshot
+{
+    static constexpr size_t x_numParams = PageManager::x_numPages * Parameter::x_numParameters;
+
+    float m_knobValue[x_numParams];
+    float m_modAmount[x_numParams];
+    uint8_t m_modIndex[x_numParams];
+
+    PresetSnapshot()
+    {
+        for (size_t i = 0; i < x_numParams; i++)
+        {
+            m_knobValue[i] = 0.0f;
+            m_modAmount[i] = 0.0f;
+            m_modIndex[i] = 255;
+        }
+    }
+
+    static Parameter* GetParameter(PageManager* pageManager, size_t index)
+    {
+        return &pageManager->m_pages[index / Parameter::x_numParameters].m_parameters[index % Parameter::x_numParameters];
+    }
+
+    void Capture(PageManager* pageManager)
+    {
+        for (size_t i = 0; i < x_numParams; i++)
+        {
+            Parameter* parameter = GetParameter(pageManager, i);
+            m_knobValue[i] = parameter->m_knobValue;
+            m_modAmount[i] = parameter->m_modAmount;
+            m_modIndex[i] = parameter->m_modIndex;
+        }
+    }
+
+    void Apply(PageManager* pageManager) const
+    {
+        for (size_t i = 0; i < x_numParams; i++)
+        {
+            Parameter* parameter = GetParameter(pageManager, i);
+            parameter->m_knobValue = m_knobValue[i];
+            parameter->m_modAmount = m_modAmount[i];
+            parameter->m_modIndex = m_modIndex[i];
+        }
+    }
+};
\ No newline at end of file
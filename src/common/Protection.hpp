@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Instrumentation.hpp"
+#include "Trace.hpp"
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+// Keeps feedback paths out of the two failure modes of float recursion:
+// subnormals, which are slow on the host, and NaN/inf, which latch in any
+// recursive state and silence the path for good.
+//
+struct Protection
+{
+    // Flush subnormal results (and operands, where the FPU supports it) to
+    // zero on the calling context.
+    //
+    // On the Cortex-M7 exception handlers do not inherit FPSCR: they start
+    // from FPDSCR, so the audio callback needs FZ set there as well.
+    //
+    static void EnableFlushToZero()
+    {
+#if defined(__arm__) && !defined(HOST_BUILD)
+        uint32_t fpscr;
+        __asm__ volatile("vmrs %0, fpscr" : "=r"(fpscr));
+        fpscr |= 1u << 24;
+        __asm__ volatile("vmsr fpscr, %0" : : "r"(fpscr));
+        FPU->FPDSCR |= FPU_FPDSCR_FZ_Msk;
+#elif defined(__aarch64__)
+        uint64_t fpcr;
+        __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+        fpcr |= 1u << 24;
+        __asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(__SSE__) || defined(_M_X64)
+        // FTZ (bit 15) and DAZ (bit 6).
+        //
+        _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+    }
+
+    // The reverse, for host tools that want subnormals to cost what they
+    // would without it.
+    //
+    static void DisableFlushToZero()
+    {
+#if defined(__aarch64__)
+        uint64_t fpcr;
+        __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+        fpcr &= ~(uint64_t(1) << 24);
+        __asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(__SSE__) || defined(_M_X64)
+        _mm_setcsr(_mm_getcsr() & ~0x8040u);
+#endif
+    }
+
+    // Once per block. A stage exposes IsFinite() over its recursive state and
+    // Reset() to clear it. Returns true if the stage was reset.
+    //
+    template<typename Stage>
+    static bool Guard(Stage* stage)
+    {
+        if (stage->IsFinite())
+        {
+            return false;
+        }
+
+        stage->Reset();
+        Instrumentation::Count(Instrumentation::Counter::NonFiniteReset);
+        Trace::Emit(Trace::Event::NonFiniteReset);
+        return true;
+    }
+};
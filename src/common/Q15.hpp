@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Q15 block helpers. Samples are int16_t in [-32768, 32767] for [-1, 1).
+// Conversions saturate and happen once at the edges of an integer segment.
+//
+// The packed helpers treat a uint32_t as two 16-bit lanes and map to the M7
+// DSP extension (UQADD16, UQSUB16) when it is available, with a portable
+// fallback on the host.
+//
+struct Q15
+{
+    static int16_t FromFloat(float x)
+    {
+        int32_t value = static_cast<int32_t>(x * 32768.0f);
+#if defined(__ARM_FEATURE_DSP) && !defined(HOST_BUILD)
+        return static_cast<int16_t>(__SSAT(value, 16));
+#else
+        return static_cast<int16_t>(value < -32768 ? -32768 : (32767 < value ? 32767 : value));
+#endif
+    }
+
+    static float ToFloat(int16_t x)
+    {
+        return x * (1.0f / 32768.0f);
+    }
+
+    static void FromFloatBlock(const float* input, int16_t* output, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            output[i] = FromFloat(input[i]);
+        }
+    }
+
+    static void ToFloatBlock(const int16_t* input, float* output, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            output[i] = ToFloat(input[i]);
+        }
+    }
+
+    static uint32_t Load2(const int16_t* samples)
+    {
+        uint32_t pair;
+        memcpy(&pair, samples, sizeof(pair));
+        return pair;
+    }
+
+    static void Store2(int16_t* samples, uint32_t pair)
+    {
+        memcpy(samples, &pair, sizeof(pair));
+    }
+
+    // Per-lane unsigned a + b, saturating at 0xFFFF.
+    //
+    static uint32_t AddLanesSaturate(uint32_t a, uint32_t b)
+    {
+#if defined(__ARM_FEATURE_DSP) && !defined(HOST_BUILD)
+        return __UQADD16(a, b);
+#else
+        uint32_t low = std::min<uint32_t>((a & 0xFFFF) + (b & 0xFFFF), 0xFFFF);
+        uint32_t high = std::min<uint32_t>((a >> 16) + (b >> 16), 0xFFFF);
+        return low | (high << 16);
+#endif
+    }
+
+    // Per-lane unsigned a - b, saturating at 0.
+    //
+    static uint32_t SubLanesSaturate(uint32_t a, uint32_t b)
+    {
+#if defined(__ARM_FEATURE_DSP) && !defined(HOST_BUILD)
+        return __UQSUB16(a, b);
+#else
+        uint32_t low = (a & 0xFFFF) < (b & 0xFFFF) ? 0 : (a & 0xFFFF) - (b & 0xFFFF);
+        uint32_t high = (a >> 16) < (b >> 16) ? 0 : (a >> 16) - (b >> 16);
+        return low | (high << 16);
+#endif
+    }
+};
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "FileSink.hpp"
+#include "FileSource.hpp"
+#include "Instrumentation.hpp"
+#include "SpscRing.hpp"
+#include "Trace.hpp"
+#include "WavFormat.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef HOST_BUILD
+#include <memory>
+#else
+#include "daisy_field.h"
+#endif
+
+// Records the two output channels to rec_NNN.wav (32-bit float, stereo) on
+// the SD card. The audio callback only interleaves each block into an SPSC
+// ring in SDRAM; the main loop drains the ring in x_chunkSize writes, which
+// start on sector boundaries thanks to a sector-sized header. The ring holds
+// about 2.7s, which covers the worst SD write stalls; a block that does not
+// fit is dropped and counted as a RecorderOverrun, never waited for.
+//
+// The header is rewritten and the file synced every x_syncChunks chunks, so
+// the FAT is updated in bounded steps and a recording cut off by power loss
+// plays up to the last sync.
+//
+struct Recorder
+{
+    static constexpr size_t x_numChannels = 2;
+    static constexpr size_t x_ringSize = 1 << 18;
+    static constexpr size_t x_chunkSize = 8192;
+    static constexpr size_t x_headerSize = 512;
+    static constexpr size_t x_syncChunks = 16;
+    static constexpr size_t x_maxFiles = 1000;
+
+    using Ring = SpscRing<float, x_ringSize>;
+
+    struct Storage
+    {
+        float m_ring[x_ringSize];
+    };
+
+    Ring m_ring;
+    Storage* m_storage;
+#ifdef HOST_BUILD
+    std::unique_ptr<Storage> m_hostStorage;
+#endif
+
+    FileSink m_file;
+    WavFormat m_format;
+    std::atomic<bool> m_capturing;
+    size_t m_chunksSinceSync;
+    char m_path[16];
+
+    Recorder()
+        : m_storage(nullptr)
+        , m_capturing(false)
+        , m_chunksSinceSync(0)
+        , m_path{}
+    {
+        m_format.m_numChannels = x_numChannels;
+    }
+
+    // One recorder per firmware on the target: there is one SDRAM block.
+    //
+    Storage* GetStorage()
+    {
+        if (!m_storage)
+        {
+#ifdef HOST_BUILD
+            m_hostStorage.reset(new Storage());
+            m_storage = m_hostStorage.get();
+#else
+            static Storage s_storage DSY_SDRAM_BSS;
+            m_storage = &s_storage;
+#endif
+        }
+
+        return m_storage;
+    }
+
+    bool IsRecording() const
+    {
+        return m_capturing.load(std::memory_order_relaxed);
+    }
+
+    // Audio callback, once per block, with what went to the outputs.
+    //
+    template<typename OutputBuffer>
+    void Capture(OutputBuffer& out, size_t size)
+    {
+        if (!m_capturing.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        float* first;
+        float* second;
+        size_t firstSize;
+        m_ring.Reserve(x_numChannels * size, &first, &firstSize, &second);
+        if (!first)
+        {
+            Instrumentation::Count(Instrumentation::Counter::RecorderOverrun);
+            Trace::Emit(Trace::Event::RecorderOverrun, static_cast<uint32_t>(x_numChannels * size));
+            return;
+        }
+
+        // The ring and the block are both whole frames, so a wrap never
+        // splits a frame.
+        //
+        for (size_t i = 0; i < size; i++)
+        {
+            float* frame = x_numChannels * i < firstSize ? first + x_numChannels * i : second + x_numChannels * i - firstSize;
+            frame[0] = out[0][i];
+            frame[1] = out[1][i];
+        }
+
+        m_ring.Publish(x_numChannels * size);
+    }
+
+    // Main loop, like everything below. Picks the first free name.
+    //
+    bool Start()
+    {
+        if (IsRecording())
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < x_maxFiles; i++)
+        {
+            snprintf(m_path, sizeof(m_path), "rec_%03u.wav", static_cast<unsigned>(i));
+            FileSource existing;
+            if (!existing.Open(m_path))
+            {
+                break;
+            }
+
+            m_path[0] = '\0';
+        }
+
+        if (m_path[0] == '\0' || !m_file.Open(m_path))
+        {
+            return false;
+        }
+
+        m_format.m_dataSize = 0;
+        m_chunksSinceSync = 0;
+        if (!WriteHeader())
+        {
+            m_file.Close();
+            return false;
+        }
+
+        m_ring.Init(GetStorage()->m_ring);
+        m_capturing.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // The callback is not running while the main loop is, so once
+    // m_capturing is clear nothing more is published.
+    //
+    void Stop()
+    {
+        if (!IsRecording())
+        {
+            return;
+        }
+
+        m_capturing.store(false, std::memory_order_release);
+        Drain(true);
+        WriteHeader();
+        m_file.Close();
+    }
+
+    void Toggle()
+    {
+        if (IsRecording())
+        {
+            Stop();
+        }
+        else
+        {
+            Start();
+        }
+    }
+
+    void Poll()
+    {
+        if (IsRecording())
+        {
+            Drain(false);
+        }
+    }
+
+    // Whole chunks only, unless finishing. A failed write (card full or
+    // pulled) ends the recording.
+    //
+    void Drain(bool finish)
+    {
+        while (true)
+        {
+            const float* data;
+            size_t available = m_ring.Peek(&data);
+            size_t count = finish ? available : (available / x_chunkSize) * x_chunkSize;
+            count = std::min(count, x_chunkSize);
+            if (count == 0)
+            {
+                return;
+            }
+
+            if (!m_file.Write(data, count * sizeof(float)))
+            {
+                m_capturing.store(false, std::memory_order_release);
+                m_file.Close();
+                return;
+            }
+
+            m_ring.Consume(count);
+            m_format.m_dataSize += count * sizeof(float);
+            if (++m_chunksSinceSync == x_syncChunks && !finish)
+            {
+                m_chunksSinceSync = 0;
+                WriteHeader();
+                m_file.Sync();
+            }
+        }
+    }
+
+    // Leaves the file positioned at the end of the samples.
+    //
+    bool WriteHeader()
+    {
+        uint8_t header[x_headerSize];
+        m_format.WriteHeader(header, x_headerSize);
+        return m_file.Seek(0) && m_file.Write(header, x_headerSize) && m_file.Seek(x_headerSize + m_format.m_dataSize);
+    }
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "SmartGridInclude.hpp"
 #include "../../External/theallelectricsmartgrid/private/src/ButterworthFilter.hpp"
+#include "StaticGraph.hpp"
 #include <cmath>
 
 struct ResonantBump
@@ -11,12 +12,14 @@ struct ResonantBump
     float m_freq;
     float m_height;
     float m_width;
+    float m_output;
 
     ResonantBump()
         : m_biquad()
         , m_freq(1000.0f)
         , m_height(1.0f)
         , m_width(1.0f)
+        , m_output(0.0f)
     {
         UpdateCoefficients();
     }
@@ -73,6 +76,35 @@ struct ResonantBump
 
     float Process(float input)
     {
-        return m_biquad.Process(input);
+        m_output = m_biquad.Process(input);
+        return m_output;
+    }
+
+    // At unity height the peak is flat; see Bypass.hpp.
+    //
+    static constexpr float x_neutralHeight = 1e-3f;
+
+    bool IsNeutral() const
+    {
+        return std::abs(m_height - 1.0f) < x_neutralHeight;
+    }
+
+    // The poles sit at radius sqrt(a2).
+    //
+    size_t TailSamples() const
+    {
+        return StageTail::Decay(1.0f, std::sqrt(std::max(m_biquad.m_a2, 0.0f)));
+    }
+
+    bool IsFinite() const
+    {
+        return std::isfinite(m_output);
+    }
+
+    void Reset()
+    {
+        m_biquad = BiquadSection();
+        UpdateCoefficients();
+        m_output = 0.0f;
     }
 };
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "AudioPipeline.hpp"
+#include "Instrumentation.hpp"
+#include "StaticGraph.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Puts the audio pipeline to sleep while there is nothing to hear. An app
+// opts in by reporting size_t TailSamples() const, the longest its output can
+// keep sounding after its input stops (see StageTail). The pipeline sleeps
+// once the input has been below x_threshold for the whole tail and the last
+// processed block came out below it too; asleep, the output is zeroed and no
+// stage runs.
+//
+// Each block's input and tail are checked before the block is processed, so
+// the block that brings the signal back is processed in full: the gate never
+// clips an onset. Going to sleep only swaps a block under -80dB for silence.
+//
+template<typename T, typename = void>
+struct HasTailSamples : std::false_type
+{
+};
+
+template<typename T>
+struct HasTailSamples<T, std::void_t<decltype(std::declval<const T&>().TailSamples())>> : std::true_type
+{
+};
+
+struct SilenceGate
+{
+    static constexpr float x_threshold = 1e-4f;
+
+    size_t m_quietSamples;
+    bool m_outputQuiet;
+    bool m_asleep;
+
+    SilenceGate()
+        : m_quietSamples(0)
+        , m_outputQuiet(false)
+        , m_asleep(false)
+    {
+    }
+
+    // Channels that carry signal: ones with stages, or passing input through.
+    //
+    static bool IsLive(const AudioPipeline& pipeline, size_t channel)
+    {
+        return pipeline.m_numStages[channel] != 0 || pipeline.m_emptyMode[channel] == AudioPipeline::EmptyMode::PassThrough;
+    }
+
+    template<typename Buffer>
+    static bool IsQuiet(const AudioPipeline& pipeline, Buffer& buffer, size_t size)
+    {
+        for (size_t channel = 0; channel < AudioPipeline::x_numChannels; channel++)
+        {
+            if (!IsLive(pipeline, channel))
+            {
+                continue;
+            }
+
+            for (size_t i = 0; i < size; i++)
+            {
+                if (x_threshold <= std::abs(buffer[channel][i]))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Before processing. True if the block can be skipped.
+    //
+    template<typename InputBuffer>
+    bool Sleep(const AudioPipeline& pipeline, InputBuffer& in, size_t size, size_t tailSamples)
+    {
+        if (!IsQuiet(pipeline, in, size))
+        {
+            m_quietSamples = 0;
+            if (m_asleep)
+            {
+                Trace::Emit(Trace::Event::SilenceWake);
+            }
+
+            m_asleep = false;
+            return false;
+        }
+
+        // Samples of quiet input before this block, which is what has to cover
+        // the tail.
+        //
+        size_t quietBefore = m_quietSamples;
+        m_quietSamples = std::min(m_quietSamples + size, StageTail::x_maxSamples + size);
+
+        // Decided afresh every block, so a tail that grows while asleep (a
+        // looper starting to play) wakes the pipeline without any input.
+        //
+        bool asleep = m_outputQuiet && tailSamples <= quietBefore;
+        if (asleep != m_asleep)
+        {
+            Trace::Emit(asleep ? Trace::Event::SilenceSleep : Trace::Event::SilenceWake);
+            m_asleep = asleep;
+        }
+
+        if (m_asleep)
+        {
+            Instrumentation::Count(Instrumentation::Counter::SilentBlock);
+        }
+
+        return m_asleep;
+    }
+
+    // After processing a block that was not skipped.
+    //
+    template<typename OutputBuffer>
+    void Observe(const AudioPipeline& pipeline, OutputBuffer& out, size_t size)
+    {
+        m_outputQuiet = IsQuiet(pipeline, out, size);
+    }
+
+    template<typename OutputBuffer>
+    static void Silence(OutputBuffer& out, size_t size)
+    {
+        for (size_t channel = 0; channel < AudioPipeline::x_numChannels; channel++)
+        {
+            memset(out[channel], 0, size * sizeof(float));
+        }
+    }
+};
\ No newline at end of file
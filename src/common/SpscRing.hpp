@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+// Single-producer, single-consumer ring over caller-supplied storage of N
+// elements, N a power of two. Indices run freely and wrap by masking, so full
+// and empty are told apart without a spare slot. The producer only stores
+// m_head and the consumer only m_tail, so neither side ever waits on the
+// other; the acquire/release pairs order the element copies against them.
+//
+template<typename T, size_t N>
+struct SpscRing
+{
+    static constexpr size_t x_size = N;
+    static constexpr size_t x_mask = N - 1;
+
+    static_assert(N != 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+    T* m_buffer;
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+
+    SpscRing()
+        : m_buffer(nullptr)
+        , m_head(0)
+        , m_tail(0)
+    {
+    }
+
+    // Only while neither side is running.
+    //
+    void Init(T* buffer)
+    {
+        m_buffer = buffer;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    size_t Readable() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+    }
+
+    size_t Writable() const
+    {
+        return N - (m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // Producer. Room for count elements, in at most two contiguous spans, or
+    // nullptr spans if there is not enough room. Fill them, then Publish.
+    //
+    void Reserve(size_t count, T** first, size_t* firstSize, T** second)
+    {
+        if (Writable() < count)
+        {
+            *first = nullptr;
+            *second = nullptr;
+            *firstSize = 0;
+            return;
+        }
+
+        size_t start = m_head.load(std::memory_order_relaxed) & x_mask;
+        *firstSize = std::min(count, N - start);
+        *first = m_buffer + start;
+        *second = m_buffer;
+    }
+
+    void Publish(size_t count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Producer. All or nothing.
+    //
+    bool Write(const T* data, size_t count)
+    {
+        T* first;
+        T* second;
+        size_t firstSize;
+        Reserve(count, &first, &firstSize, &second);
+        if (!first)
+        {
+            return false;
+        }
+
+        memcpy(first, data, firstSize * sizeof(T));
+        memcpy(second, data + firstSize, (count - firstSize) * sizeof(T));
+        Publish(count);
+        return true;
+    }
+
+    // Consumer. The readable elements up to the end of the storage, so they
+    // can be handed on without a copy. Release them with Consume.
+    //
+    size_t Peek(const T** data) const
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        *data = m_buffer + (tail & x_mask);
+        return std::min(Readable(), N - (tail & x_mask));
+    }
+
+    void Consume(size_t count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+};
\ No newline at end of file
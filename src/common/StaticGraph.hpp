@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+// Compile-time composition of per-sample stages. Any type with
+// float Process(float) is a stage, and Chain and Parallel are stages too, so
+// graphs nest. The whole graph is one type, so the compiler sees every
+// Process call and can inline the lot into a single fused block loop.
+//
+// A stage may report size_t TailSamples() const: how long, at its
+// current settings, its output takes to fall by x_decay once its input stops.
+// StageTail has the usual estimates. Anything that cannot be bounded reports
+// x_maxSamples.
+//
+struct StageTail
+{
+    static constexpr float x_decay = 1e-4f;
+    static constexpr float x_logDecay = -9.21034037f;
+    static constexpr size_t x_maxSamples = 10 * 48000;
+
+    // A recursion whose state shrinks by gain every period samples.
+    //
+    static size_t Decay(float period, float gain)
+    {
+        gain = std::abs(gain);
+        if (gain < x_decay)
+        {
+            return static_cast<size_t>(period) + 1;
+        }
+
+        if (1.0f <= gain)
+        {
+            return x_maxSamples;
+        }
+
+        float samples = period * (1.0f + x_logDecay / std::log(gain));
+        return std::min(static_cast<size_t>(samples) + 1, x_maxSamples);
+    }
+
+    // A one-pole y += alpha * (x - y).
+    //
+    static size_t OnePole(float alpha)
+    {
+        return Decay(1.0f, 1.0f - alpha);
+    }
+};
+
+// Stages in series: each one's output feeds the next.
+//
+template<typename... Stages>
+struct Chain
+{
+    static constexpr size_t x_stateSize = (sizeof(Stages) + ... + 0);
+    static constexpr size_t x_numStages = sizeof...(Stages);
+
+    std::tuple<Stages...> m_stages;
+
+    template<size_t I>
+    auto& Get()
+    {
+        return std::get<I>(m_stages);
+    }
+
+    float Process(float input)
+    {
+        return std::apply([&](Stages&... stages)
+        {
+            ((input = stages.Process(input)), ...);
+            return input;
+        }, m_stages);
+    }
+
+    void ProcessBlock(const float* input, float* output, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            output[i] = Process(input[i]);
+        }
+    }
+
+    // Tails add up along a chain.
+    //
+    size_t TailSamples() const
+    {
+        return std::apply([](const Stages&... stages)
+        {
+            return std::min((stages.TailSamples() + ... + size_t(0)), StageTail::x_maxSamples);
+        }, m_stages);
+    }
+
+    // Same, with a per-sample hook run before each sample, for per-sample
+    // parameter smoothing that must land between samples.
+    //
+    template<typename Hook>
+    void ProcessBlock(const float* input, float* output, size_t size, Hook hook)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hook(i);
+            output[i] = Process(input[i]);
+        }
+    }
+};
+
+// Stages side by side on the same input, outputs summed. Branches are not
+// time-aligned; put a delay stage in a branch that needs it.
+//
+template<typename... Stages>
+struct Parallel
+{
+    static constexpr size_t x_stateSize = (sizeof(Stages) + ... + 0);
+    static constexpr size_t x_numStages = sizeof...(Stages);
+
+    std::tuple<Stages...> m_stages;
+
+    template<size_t I>
+    auto& Get()
+    {
+        return std::get<I>(m_stages);
+    }
+
+    float Process(float input)
+    {
+        return std::apply([&](Stages&... stages)
+        {
+            float sum = 0.0f;
+            ((sum += stages.Process(input)), ...);
+            return sum;
+        }, m_stages);
+    }
+
+    size_t TailSamples() const
+    {
+        return std::apply([](const Stages&... stages)
+        {
+            return std::max({size_t(0), stages.TailSamples()...});
+        }, m_stages);
+    }
+
+    void ProcessBlock(const float* input, float* output, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            output[i] = Process(input[i]);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "daisy_field.h"
+
+// Event trace for the audio callback, the other interrupts and the main loop.
+// Emit() writes a fixed-size binary record (microsecond timestamp, event, two
+// arguments) into a ring and returns; nothing is formatted and nothing
+// blocks. The main loop Drain()s the ring, formats each record from the
+// event's format string and hands the line to a sink: USB serial on the
+// target, stdout or a file on the host.
+//
+// Any context may Emit(), and an interrupt may preempt another writer. A
+// writer claims a slot with one atomic increment of the head, then fills it
+// seqlock style: the slot's stamp is cleared, the fields written, and the
+// stamp set to the claimed index + 1. The reader takes a record only if the
+// stamp matches before and after the copy. When the ring laps the reader,
+// the oldest records are overwritten and counted as lost.
+//
+struct Trace
+{
+    enum class Event : uint16_t
+    {
+        NonFiniteReset = 0,
+        BlockOverrun = 1,
+        ControlFrameLate = 2,
+        RecorderOverrun = 3,
+        MidiDrop = 4,
+        ClockLock = 5,
+        ClockUnlock = 6,
+        SilenceSleep = 7,
+        SilenceWake = 8,
+        PresetRecall = 9,
+        NumEvents = 10,
+    };
+
+    static constexpr size_t x_numEvents = static_cast<size_t>(Event::NumEvents);
+    static constexpr size_t x_size = 512;
+    static constexpr uint32_t x_mask = x_size - 1;
+    static constexpr size_t x_maxLine = 96;
+
+    static_assert((x_size & x_mask) == 0, "Trace ring size must be a power of two");
+
+    // Formats take the two arguments as unsigned ints, in order, and may use
+    // fewer.
+    //
+    static inline const char* x_formats[x_numEvents] =
+    {
+        "NonFiniteReset",
+        "BlockOverrun %uus of %uus",
+        "ControlFrameLate, frame %u reused",
+        "RecorderOverrun %u samples dropped",
+        "MidiDrop status %02x, %u dropped",
+        "ClockLock period %u samples",
+        "ClockUnlock",
+        "SilenceSleep",
+        "SilenceWake",
+        "PresetRecall slot %u",
+    };
+
+    // Fields are relaxed atomics so a torn read is only ever a stale value,
+    // which the stamp check throws away.
+    //
+    struct Record
+    {
+        std::atomic<uint32_t> m_stamp;
+        std::atomic<uint32_t> m_time;
+        std::atomic<uint32_t> m_event;
+        std::atomic<uint32_t> m_arg0;
+        std::atomic<uint32_t> m_arg1;
+    };
+
+    typedef void (*Sink)(void* context, const char* line);
+
+    static inline Record s_records[x_size] = {};
+    static inline std::atomic<uint32_t> s_head{0};
+
+    // Reader state, main loop only.
+    //
+    static inline uint32_t s_tail = 0;
+    static inline uint32_t s_lost = 0;
+
+    static void Emit(Event event, uint32_t arg0 = 0, uint32_t arg1 = 0)
+    {
+        uint32_t index = s_head.fetch_add(1, std::memory_order_relaxed);
+        Record& record = s_records[index & x_mask];
+        record.m_stamp.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        record.m_time.store(daisy::System::GetUs(), std::memory_order_relaxed);
+        record.m_event.store(static_cast<uint32_t>(event), std::memory_order_relaxed);
+        record.m_arg0.store(arg0, std::memory_order_relaxed);
+        record.m_arg1.store(arg1, std::memory_order_relaxed);
+        record.m_stamp.store(index + 1, std::memory_order_release);
+    }
+
+    // Formats and sinks every complete record, oldest first. Stops early at a
+    // slot still being written; the next Drain() picks it up. Returns the
+    // number of lines written.
+    //
+    static size_t Drain(Sink sink, void* context)
+    {
+        uint32_t head = s_head.load(std::memory_order_acquire);
+        if (x_size < head - s_tail)
+        {
+            s_lost += head - s_tail - x_size;
+            s_tail = head - x_size;
+        }
+
+        size_t numLines = 0;
+        char line[x_maxLine];
+        while (s_tail != head)
+        {
+            Record& record = s_records[s_tail & x_mask];
+            uint32_t expected = s_tail + 1;
+            uint32_t stamp = record.m_stamp.load(std::memory_order_acquire);
+            if (stamp != expected)
+            {
+                // A later lap has taken the slot, or this one is not done.
+                //
+                if (static_cast<int32_t>(stamp - expected) > 0)
+                {
+                    s_lost++;
+                    s_tail++;
+                    continue;
+                }
+
+                break;
+            }
+
+            uint32_t time = record.m_time.load(std::memory_order_relaxed);
+            uint32_t event = record.m_event.load(std::memory_order_relaxed);
+            uint32_t arg0 = record.m_arg0.load(std::memory_order_relaxed);
+            uint32_t arg1 = record.m_arg1.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s_tail++;
+            if (record.m_stamp.load(std::memory_order_relaxed) != stamp || x_numEvents <= event)
+            {
+                s_lost++;
+                continue;
+            }
+
+            Format(line, time, event, arg0, arg1);
+            sink(context, line);
+            numLines++;
+        }
+
+        if (s_lost)
+        {
+            snprintf(line, sizeof(line), "trace: %u records lost", static_cast<unsigned>(s_lost));
+            sink(context, line);
+            s_lost = 0;
+            numLines++;
+        }
+
+        return numLines;
+    }
+
+    static void Format(char* line, uint32_t time, uint32_t event, uint32_t arg0, uint32_t arg1)
+    {
+        int prefix = snprintf(line, x_maxLine, "%10u ", static_cast<unsigned>(time));
+        if (0 < prefix && static_cast<size_t>(prefix) < x_maxLine)
+        {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+            snprintf(line + prefix, x_maxLine - prefix, x_formats[event], static_cast<unsigned>(arg0), static_cast<unsigned>(arg1));
+#pragma GCC diagnostic pop
+        }
+    }
+
+    // Sink for a FILE*, the host tools' stdout or trace file.
+    //
+    static void PrintToFile(void* context, const char* line)
+    {
+        fprintf(static_cast<FILE*>(context), "%s\n", line);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Minimal RIFF/WAVE handling shared by the host tools and the on-target file
+// code. Reading walks the chunk list of any Source with Read(dst, size) and
+// Skip(size); writing produces the canonical 44-byte header.
+//
+struct WavFormat
+{
+    static constexpr size_t x_headerSize = 44;
+
+    enum class Encoding : uint16_t
+    {
+        PCM = 1,
+        Float = 3,
+    };
+
+    Encoding m_encoding;
+    uint16_t m_numChannels;
+    uint32_t m_sampleRate;
+    uint16_t m_bitsPerSample;
+    uint32_t m_dataSize;
+
+    WavFormat()
+        : m_encoding(Encoding::Float)
+        , m_numChannels(1)
+        , m_sampleRate(48000)
+        , m_bitsPerSample(32)
+        , m_dataSize(0)
+    {
+    }
+
+    size_t BytesPerFrame() const
+    {
+        return m_numChannels * (m_bitsPerSample / 8);
+    }
+
+    size_t NumFrames() const
+    {
+        return BytesPerFrame() ? m_dataSize / BytesPerFrame() : 0;
+    }
+
+    bool IsSupported() const
+    {
+        if (m_encoding == Encoding::Float)
+        {
+            return m_bitsPerSample == 32;
+        }
+
+        return m_encoding == Encoding::PCM && (m_bitsPerSample == 16 || m_bitsPerSample == 24 || m_bitsPerSample == 32);
+    }
+
+    static uint32_t ReadU32(const uint8_t* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    static uint16_t ReadU16(const uint8_t* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    static void WriteU32(uint8_t* p, uint32_t value)
+    {
+        p[0] = value & 0xFF;
+        p[1] = (value >> 8) & 0xFF;
+        p[2] = (value >> 16) & 0xFF;
+        p[3] = (value >> 24) & 0xFF;
+    }
+
+    static void WriteU16(uint8_t* p, uint16_t value)
+    {
+        p[0] = value & 0xFF;
+        p[1] = (value >> 8) & 0xFF;
+    }
+
+    // Leaves the source positioned at the first sample.
+    //
+    template<typename Source>
+    bool ReadHeader(Source* source)
+    {
+        uint8_t riff[12];
+        if (!source->Read(riff, 12) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            return false;
+        }
+
+        bool haveFormat = false;
+        while (true)
+        {
+            uint8_t chunk[8];
+            if (!source->Read(chunk, 8))
+            {
+                return false;
+            }
+
+            uint32_t chunkSize = ReadU32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0)
+            {
+                uint8_t format[16];
+                if (chunkSize < 16 || !source->Read(format, 16))
+                {
+                    return false;
+                }
+
+                m_encoding = static_cast<Encoding>(ReadU16(format));
+                m_numChannels = ReadU16(format + 2);
+                m_sampleRate = ReadU32(format + 4);
+                m_bitsPerSample = ReadU16(format + 14);
+
+                // WAVE_FORMAT_EXTENSIBLE keeps the real encoding in the sub-format.
+                //
+                if (static_cast<uint16_t>(m_encoding) == 0xFFFE && 40 <= chunkSize)
+                {
+                    uint8_t extension[24];
+                    if (!source->Read(extension, 24))
+                    {
+                        return false;
+                    }
+
+                    m_encoding = static_cast<Encoding>(ReadU16(extension + 8));
+                    chunkSize -= 24;
+                }
+
+                source->Skip(chunkSize - 16 + (chunkSize & 1));
+                haveFormat = true;
+            }
+            else if (memcmp(chunk, "data", 4) == 0)
+            {
+                m_dataSize = chunkSize;
+                return haveFormat && IsSupported();
+            }
+            else
+            {
+                source->Skip(chunkSize + (chunkSize & 1));
+            }
+        }
+    }
+
+    void WriteHeader(uint8_t* header) const
+    {
+        WriteHeader(header, x_headerSize);
+    }
+
+    // A header of headerSize bytes (even, and x_headerSize or at least 8
+    // more), padded with a JUNK chunk, so the samples can start on a sector
+    // boundary. Readers skip the padding like any unknown chunk.
+    //
+    void WriteHeader(uint8_t* header, size_t headerSize) const
+    {
+        memcpy(header, "RIFF", 4);
+        WriteU32(header + 4, headerSize - 8 + m_dataSize);
+        memcpy(header + 8, "WAVE", 4);
+
+        uint8_t* p = header + 12;
+        if (x_headerSize < headerSize)
+        {
+            size_t junkSize = headerSize - x_headerSize - 8;
+            memcpy(p, "JUNK", 4);
+            WriteU32(p + 4, junkSize);
+            memset(p + 8, 0, junkSize);
+            p += 8 + junkSize;
+        }
+
+        memcpy(p, "fmt ", 4);
+        WriteU32(p + 4, 16);
+        WriteU16(p + 8, static_cast<uint16_t>(m_encoding));
+        WriteU16(p + 10, m_numChannels);
+        WriteU32(p + 12, m_sampleRate);
+        WriteU32(p + 16, m_sampleRate * BytesPerFrame());
+        WriteU16(p + 20, BytesPerFrame());
+        WriteU16(p + 22, m_bitsPerSample);
+        memcpy(p + 24, "data", 4);
+        WriteU32(p + 28, m_dataSize);
+    }
+
+    float DecodeSample(const uint8_t* p) const
+    {
+        if (m_encoding == Encoding::Float)
+        {
+            float value;
+            memcpy(&value, p, sizeof(float));
+            return value;
+        }
+
+        switch (m_bitsPerSample)
+        {
+            case 16:
+            {
+                return static_cast<int16_t>(ReadU16(p)) / 32768.0f;
+            }
+            case 24:
+            {
+                int32_t value = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+                return value / 8388608.0f;
+            }
+            default:
+            {
+                return static_cast<int32_t>(ReadU32(p)) / 2147483648.0f;
+            }
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "HostApp.hpp"
+#include "MidiFile.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Timestamped control events for offline renders, one per line:
+//
+//   <seconds> param <page> <slot> <value>    set a knob (value in [0, 1])
+//   <seconds> mod <page> <slot> <source> <amount>
+//                                            route a knob to a mod source
+//                                            (255 clears the routing)
+//   <seconds> cv <n> <value>                 set CV input n (value in [0, 1])
+//   <seconds> gate <0|1>                     set the gate level
+//   <seconds> trigger                        a 1ms gate pulse
+//   <seconds> button <n>                     press a button
+//
+// Blank lines and anything after '#' are ignored. Events need not be sorted.
+// A MIDI file can be played alongside (ReadMidi); its messages are sent as
+// they would arrive on the MIDI input.
+//
+struct Automation
+{
+    static constexpr float x_triggerSeconds = 0.001f;
+
+    enum class Type : uint8_t
+    {
+        Param = 0,
+        Gate = 1,
+        Button = 2,
+        Mod = 3,
+        Cv = 4,
+    };
+
+    struct Event
+    {
+        uint64_t m_frame;
+        Type m_type;
+        uint8_t m_page;
+        uint8_t m_slot;
+        uint8_t m_source;
+        float m_value;
+    };
+
+    std::vector<Event> m_events;
+    std::vector<MidiFile::Message> m_midi;
+    std::string m_error;
+
+    bool ReadMidi(const std::string& path, uint32_t sampleRate)
+    {
+        MidiFile file;
+        if (!file.Read(path, sampleRate))
+        {
+            m_error = file.m_error;
+            return false;
+        }
+
+        m_midi = file.m_messages;
+        return true;
+    }
+
+    bool Read(const std::string& path, uint32_t sampleRate)
+    {
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file)
+        {
+            m_error = path + ": cannot open";
+            return false;
+        }
+
+        char line[256];
+        size_t lineNumber = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), file))
+        {
+            lineNumber++;
+            ok = ParseLine(line, sampleRate);
+            if (!ok)
+            {
+                m_error = path + ":" + std::to_string(lineNumber) + ": bad event";
+            }
+        }
+
+        fclose(file);
+        std::stable_sort(m_events.begin(), m_events.end(), [](const Event& a, const Event& b)
+        {
+            return a.m_frame < b.m_frame;
+        });
+
+        return ok;
+    }
+
+    bool ParseLine(char* line, uint32_t sampleRate)
+    {
+        char* comment = strchr(line, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+
+        double seconds;
+        char type[16];
+        int consumed = 0;
+        if (sscanf(line, " %lf %15s %n", &seconds, type, &consumed) < 2)
+        {
+            // Blank lines are fine, anything else is not.
+            //
+            return sscanf(line, " %15s", type) < 1;
+        }
+
+        if (seconds < 0)
+        {
+            return false;
+        }
+
+        Event event{static_cast<uint64_t>(seconds * sampleRate + 0.5), Type::Param, 0, 0, 0, 0.0f};
+        const char* args = line + consumed;
+        if (strcmp(type, "param") == 0)
+        {
+            unsigned page;
+            unsigned slot;
+            if (sscanf(args, "%u %u %f", &page, &slot, &event.m_value) != 3 || page >= PageManager::x_numPages || slot >= Parameter::x_numParameters)
+            {
+                return false;
+            }
+
+            event.m_page = page;
+            event.m_slot = slot;
+        }
+        else if (strcmp(type, "mod") == 0)
+        {
+            unsigned page;
+            unsigned slot;
+            unsigned source;
+            if (sscanf(args, "%u %u %u %f", &page, &slot, &source, &event.m_value) != 4 || page >= PageManager::x_numPages || slot >= Parameter::x_numParameters || source > 255)
+            {
+                return false;
+            }
+
+            event.m_type = Type::Mod;
+            event.m_page = page;
+            event.m_slot = slot;
+            event.m_source = source;
+        }
+        else if (strcmp(type, "cv") == 0)
+        {
+            unsigned index;
+            if (sscanf(args, "%u %f", &index, &event.m_value) != 2 || index >= daisy::DaisyField::x_numCvs)
+            {
+                return false;
+            }
+
+            event.m_type = Type::Cv;
+            event.m_slot = index;
+        }
+        else if (strcmp(type, "gate") == 0)
+        {
+            event.m_type = Type::Gate;
+            if (sscanf(args, "%f", &event.m_value) != 1)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(type, "trigger") == 0)
+        {
+            event.m_type = Type::Gate;
+            event.m_value = 1.0f;
+            m_events.push_back(event);
+            event.m_frame += static_cast<uint64_t>(x_triggerSeconds * sampleRate);
+            event.m_value = 0.0f;
+        }
+        else if (strcmp(type, "button") == 0)
+        {
+            unsigned button;
+            if (sscanf(args, "%u", &button) != 1)
+            {
+                return false;
+            }
+
+            event.m_type = Type::Button;
+            event.m_slot = button;
+        }
+        else
+        {
+            return false;
+        }
+
+        m_events.push_back(event);
+        return true;
+    }
+
+    template<typename T>
+    static void Apply(HostApp<T>* app, const Event& event)
+    {
+        switch (event.m_type)
+        {
+            case Type::Param:
+            {
+                app->SetParam(event.m_page, event.m_slot, event.m_value);
+                break;
+            }
+            case Type::Gate:
+            {
+                app->SetGate(event.m_value > 0.5f);
+                break;
+            }
+            case Type::Button:
+            {
+                app->PressButton(event.m_slot);
+                break;
+            }
+            case Type::Mod:
+            {
+                app->SetMod(event.m_page, event.m_slot, event.m_source, event.m_value);
+                break;
+            }
+            case Type::Cv:
+            {
+                app->SetCv(event.m_slot, event.m_value);
+                break;
+            }
+        }
+    }
+
+    // Renders in blocks of at most HostApp::x_blockSize, cutting blocks short
+    // at event times so every event lands on the block that starts at its
+    // frame, as it would on hardware with the control read at the block edge.
+    //
+    template<typename T>
+    void Render(HostApp<T>* app, const float* inLeft, const float* inRight, float* outLeft, float* outRight, size_t numFrames) const
+    {
+        size_t next = 0;
+        size_t nextMidi = 0;
+        size_t frame = 0;
+        while (frame < numFrames)
+        {
+            while (next < m_events.size() && m_events[next].m_frame <= frame)
+            {
+                Apply(app, m_events[next]);
+                next++;
+            }
+
+            size_t size = std::min(HostApp<T>::x_blockSize, numFrames - frame);
+            if (next < m_events.size())
+            {
+                size = std::min<size_t>(size, m_events[next].m_frame - frame);
+            }
+
+            // MIDI needs no block cuts: it lands at its offset either way.
+            //
+            while (nextMidi < m_midi.size() && m_midi[nextMidi].m_frame < frame + size)
+            {
+                app->SendMidi(m_midi[nextMidi].m_bytes, m_midi[nextMidi].m_size, m_midi[nextMidi].m_frame);
+                nextMidi++;
+            }
+
+            app->ProcessBlock(inLeft + frame, inRight + frame, outLeft + frame, outRight + frame, size);
+            frame += size;
+        }
+    }
+};
\ No newline at end of file
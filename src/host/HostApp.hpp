@@ -0,0 +1,110 @@
+#pragma once
+
+#include "App.hpp"
+#include <memory>
+
+// Runs an App<T> off the hardware: configures it the way App::Init would,
+// minus the board bring-up, and feeds it audio in fixed-size blocks.
+//
+template<typename T>
+struct HostApp
+{
+    static constexpr size_t x_blockSize = 48;
+
+    std::unique_ptr<App<T>> m_app;
+    uint64_t m_frame;
+
+    HostApp()
+        : m_app(new App<T>())
+        , m_frame(0)
+    {
+        // MXCSR is per thread, so this covers the thread that renders.
+        //
+        Protection::EnableFlushToZero();
+        m_app->Config();
+        m_app->m_daisyIO.m_buttonCallback = App<T>::StaticButtonCallback;
+        App<T>::s_instance = m_app.get();
+        m_app->m_daisyIO.m_pageManager.Finalize();
+    }
+
+    PageManager& GetPageManager()
+    {
+        return m_app->m_daisyIO.m_pageManager;
+    }
+
+    daisy::DaisyField& GetField()
+    {
+        return m_app->m_daisyIO.m_field;
+    }
+
+    void SetParam(uint8_t page, uint8_t slot, float value)
+    {
+        GetPageManager().m_pages[page].m_parameters[slot].m_knobValue = value;
+    }
+
+    // Routes a knob to a mod source (ModMgr index) at amount, as mod tracking
+    // would. A source past the last one clears the routing.
+    //
+    void SetMod(uint8_t page, uint8_t slot, uint8_t source, float amount)
+    {
+        Parameter& parameter = GetPageManager().m_pages[page].m_parameters[slot];
+        parameter.m_modIndex = source < ModMgr::x_numMods ? source : 255;
+        parameter.m_modAmount = amount;
+    }
+
+    // CV inputs feed the first mod sources. Nothing reads the jacks on the
+    // host, so a value holds until set again.
+    //
+    void SetCv(size_t index, float value)
+    {
+        GetPageManager().m_modMgr.m_mods[index] = value;
+    }
+
+    // The gate pin is read at the top of the next block.
+    //
+    void SetGate(bool high)
+    {
+        GetField().gate_in.m_state = high;
+    }
+
+    void PressButton(int button)
+    {
+        m_app->ButtonCallback(button);
+    }
+
+    // MIDI bytes as they arrive on the wire, timed in frames. Messages are
+    // handed to the app at the top of the block after the one they fall in,
+    // at their offset, like on the hardware; later frames wait in the queue.
+    //
+    void SendMidi(const uint8_t* bytes, size_t size, uint64_t frame)
+    {
+        m_app->m_daisyIO.m_midi.Receive(bytes, size, static_cast<uint32_t>(frame));
+    }
+
+    // Processes one block of at most x_blockSize frames.
+    //
+    void ProcessBlock(const float* inLeft, const float* inRight, float* outLeft, float* outRight, size_t size)
+    {
+        const float* in[2] = {inLeft, inRight};
+        float* out[2] = {outLeft, outRight};
+        daisy::AudioHandle::InputBuffer inBuffer = in;
+        daisy::AudioHandle::OutputBuffer outBuffer = out;
+        m_app->m_daisyIO.m_midi.m_hostNow = static_cast<uint32_t>(m_frame);
+        m_app->Process(inBuffer, outBuffer, size);
+        m_frame += size;
+
+        // The main loop's share: pickup for the block's CCs, which the audio
+        // side has already applied at their offsets.
+        //
+        m_app->m_daisyIO.ApplyMidiCcs();
+    }
+
+    void Render(const float* inLeft, const float* inRight, float* outLeft, float* outRight, size_t numFrames)
+    {
+        for (size_t i = 0; i < numFrames; i += x_blockSize)
+        {
+            size_t size = std::min(x_blockSize, numFrames - i);
+            ProcessBlock(inLeft + i, inRight + i, outLeft + i, outRight + i, size);
+        }
+    }
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Standard MIDI File reader for host tools: formats 0 and 1, tracks merged,
+// times converted to frames through the file's tempo map. Channel messages
+// and real-time bytes are kept as they are sent on the wire; meta events
+// (other than tempo) and SysEx are dropped.
+//
+struct MidiFile
+{
+    struct Message
+    {
+        uint64_t m_frame;
+        uint8_t m_bytes[3];
+        uint8_t m_size;
+    };
+
+    std::vector<Message> m_messages;
+    std::string m_error;
+
+    static uint32_t ReadU32(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    static uint16_t ReadU16(const uint8_t* p)
+    {
+        return (p[0] << 8) | p[1];
+    }
+
+    bool Read(const std::string& path, uint32_t sampleRate)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            m_error = path + ": cannot open";
+            return false;
+        }
+
+        std::vector<uint8_t> data;
+        uint8_t buffer[4096];
+        size_t bytesRead;
+        while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) != 0)
+        {
+            data.insert(data.end(), buffer, buffer + bytesRead);
+        }
+
+        fclose(file);
+        if (!Parse(data.data(), data.size(), sampleRate))
+        {
+            m_error = path + ": " + m_error;
+            return false;
+        }
+
+        return true;
+    }
+
+    struct Tempo
+    {
+        uint64_t m_tick;
+        uint32_t m_microsPerBeat;
+    };
+
+    bool Parse(const uint8_t* data, size_t size, uint32_t sampleRate)
+    {
+        m_messages.clear();
+        if (size < 14 || memcmp(data, "MThd", 4) != 0 || ReadU32(data + 4) < 6)
+        {
+            m_error = "not a MIDI file";
+            return false;
+        }
+
+        uint16_t format = ReadU16(data + 8);
+        uint16_t numTracks = ReadU16(data + 10);
+        uint16_t division = ReadU16(data + 12);
+        if (1 < format || (division & 0x8000) || division == 0)
+        {
+            m_error = "only formats 0 and 1 with ticks per beat are supported";
+            return false;
+        }
+
+        // Messages are collected in ticks first, since a tempo change in one
+        // track applies to all of them.
+        //
+        std::vector<std::pair<uint64_t, Message>> timed;
+        std::vector<Tempo> tempos;
+        size_t pos = 8 + ReadU32(data + 4);
+        for (uint16_t track = 0; track < numTracks; track++)
+        {
+            if (size < pos + 8 || memcmp(data + pos, "MTrk", 4) != 0)
+            {
+                m_error = "bad track header";
+                return false;
+            }
+
+            size_t end = pos + 8 + ReadU32(data + pos + 4);
+            if (size < end)
+            {
+                m_error = "truncated track";
+                return false;
+            }
+
+            if (!ParseTrack(data + pos + 8, data + end, &timed, &tempos))
+            {
+                return false;
+            }
+
+            pos = end;
+        }
+
+        std::stable_sort(timed.begin(), timed.end(), [](const std::pair<uint64_t, Message>& a, const std::pair<uint64_t, Message>& b)
+        {
+            return a.first < b.first;
+        });
+
+        std::stable_sort(tempos.begin(), tempos.end(), [](const Tempo& a, const Tempo& b)
+        {
+            return a.m_tick < b.m_tick;
+        });
+
+        // Walk the tempo map alongside the messages.
+        //
+        double seconds = 0.0;
+        uint64_t tick = 0;
+        double secondsPerTick = 0.5 / division;
+        size_t nextTempo = 0;
+        for (std::pair<uint64_t, Message>& entry : timed)
+        {
+            while (nextTempo < tempos.size() && tempos[nextTempo].m_tick <= entry.first)
+            {
+                seconds += (tempos[nextTempo].m_tick - tick) * secondsPerTick;
+                tick = tempos[nextTempo].m_tick;
+                secondsPerTick = tempos[nextTempo].m_microsPerBeat * 1e-6 / division;
+                nextTempo++;
+            }
+
+            double messageSeconds = seconds + (entry.first - tick) * secondsPerTick;
+            entry.second.m_frame = static_cast<uint64_t>(messageSeconds * sampleRate + 0.5);
+            m_messages.push_back(entry.second);
+        }
+
+        return true;
+    }
+
+    bool ReadVarLen(const uint8_t** p, const uint8_t* end, uint32_t* value)
+    {
+        *value = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (*p == end)
+            {
+                break;
+            }
+
+            uint8_t byte = *(*p)++;
+            *value = (*value << 7) | (byte & 0x7F);
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+
+        m_error = "bad variable-length number";
+        return false;
+    }
+
+    bool ParseTrack(const uint8_t* p, const uint8_t* end, std::vector<std::pair<uint64_t, Message>>* timed, std::vector<Tempo>* tempos)
+    {
+        uint64_t tick = 0;
+        uint8_t status = 0;
+        while (p < end)
+        {
+            uint32_t delta;
+            if (!ReadVarLen(&p, end, &delta) || p == end)
+            {
+                m_error = "truncated event";
+                return false;
+            }
+
+            tick += delta;
+            uint8_t byte = *p;
+            if (byte == 0xFF)
+            {
+                if (end < p + 2)
+                {
+                    m_error = "truncated meta event";
+                    return false;
+                }
+
+                uint8_t type = p[1];
+                p += 2;
+                uint32_t length;
+                if (!ReadVarLen(&p, end, &length) || end < p + length)
+                {
+                    m_error = "truncated meta event";
+                    return false;
+                }
+
+                if (type == 0x51 && length == 3)
+                {
+                    tempos->push_back({tick, (static_cast<uint32_t>(p[0]) << 16) | (p[1] << 8) | p[2]});
+                }
+
+                p += length;
+                continue;
+            }
+
+            if (byte == 0xF0 || byte == 0xF7)
+            {
+                p++;
+                uint32_t length;
+                if (!ReadVarLen(&p, end, &length) || end < p + length)
+                {
+                    m_error = "truncated SysEx";
+                    return false;
+                }
+
+                p += length;
+                continue;
+            }
+
+            Message message{0, {0, 0, 0}, 0};
+            if (byte & 0x80)
+            {
+                p++;
+                if (byte < 0xF0)
+                {
+                    status = byte;
+                }
+                else
+                {
+                    // Real-time and system common bytes sent as they are.
+                    //
+                    message.m_bytes[0] = byte;
+                    message.m_size = 1;
+                    timed->push_back({tick, message});
+                    continue;
+                }
+            }
+            else if (status == 0)
+            {
+                m_error = "data byte without status";
+                return false;
+            }
+
+            uint8_t numData = (status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0 ? 1 : 2;
+            if (end < p + numData)
+            {
+                m_error = "truncated message";
+                return false;
+            }
+
+            message.m_bytes[0] = status;
+            for (uint8_t i = 0; i < numData; i++)
+            {
+                message.m_bytes[1 + i] = *p++;
+            }
+
+            message.m_size = 1 + numData;
+            timed->push_back({tick, message});
+        }
+
+        return true;
+    }
+};
\ No newline at end of file
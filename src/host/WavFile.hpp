@@ -0,0 +1,108 @@
+#pragma once
+
+#include "WavFormat.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Reads any supported WAV into per-channel float buffers, and writes 32-bit
+// float WAVs so rendered output round-trips bit for bit.
+//
+struct WavFile
+{
+    struct FileSource
+    {
+        FILE* m_file;
+
+        bool Read(void* dst, size_t size)
+        {
+            return fread(dst, 1, size, m_file) == size;
+        }
+
+        void Skip(size_t size)
+        {
+            fseek(m_file, size, SEEK_CUR);
+        }
+    };
+
+    uint32_t m_sampleRate;
+    std::vector<std::vector<float>> m_channels;
+
+    WavFile()
+        : m_sampleRate(48000)
+    {
+    }
+
+    size_t NumFrames() const
+    {
+        return m_channels.empty() ? 0 : m_channels[0].size();
+    }
+
+    bool Read(const std::string& path)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            return false;
+        }
+
+        FileSource source{file};
+        WavFormat format;
+        if (!format.ReadHeader(&source))
+        {
+            fclose(file);
+            return false;
+        }
+
+        std::vector<uint8_t> data(format.m_dataSize);
+        size_t bytesRead = fread(data.data(), 1, data.size(), file);
+        fclose(file);
+
+        size_t numFrames = bytesRead / format.BytesPerFrame();
+        size_t bytesPerSample = format.m_bitsPerSample / 8;
+        m_sampleRate = format.m_sampleRate;
+        m_channels.assign(format.m_numChannels, std::vector<float>(numFrames));
+        for (size_t i = 0; i < numFrames; i++)
+        {
+            for (size_t j = 0; j < format.m_numChannels; j++)
+            {
+                m_channels[j][i] = format.DecodeSample(&data[i * format.BytesPerFrame() + j * bytesPerSample]);
+            }
+        }
+
+        return true;
+    }
+
+    bool Write(const std::string& path) const
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+
+        WavFormat format;
+        format.m_encoding = WavFormat::Encoding::Float;
+        format.m_numChannels = m_channels.size();
+        format.m_sampleRate = m_sampleRate;
+        format.m_bitsPerSample = 32;
+        format.m_dataSize = NumFrames() * format.BytesPerFrame();
+
+        uint8_t header[WavFormat::x_headerSize];
+        format.WriteHeader(header);
+        fwrite(header, 1, WavFormat::x_headerSize, file);
+
+        std::vector<float> interleaved(NumFrames() * m_channels.size());
+        for (size_t i = 0; i < NumFrames(); i++)
+        {
+            for (size_t j = 0; j < m_channels.size(); j++)
+            {
+                interleaved[i * m_channels.size() + j] = m_channels[j][i];
+            }
+        }
+
+        bool ok = fwrite(interleaved.data(), sizeof(float), interleaved.size(), file) == interleaved.size();
+        fclose(file);
+        return ok;
+    }
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+// Host stand-in for the parts of libDaisy's DaisyField that DaisyIO and the
+// apps touch. Controls are plain state the host tools can set; everything that
+// would talk to hardware does nothing.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+struct FontDef
+{
+};
+
+static FontDef Font_6x8;
+
+namespace daisy
+{
+
+struct AudioHandle
+{
+    typedef const float* const* InputBuffer;
+    typedef float** OutputBuffer;
+    typedef void (*AudioCallback)(InputBuffer in, OutputBuffer out, size_t size);
+};
+
+struct System
+{
+    static void Delay(uint32_t milliseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+
+    static uint32_t GetNow()
+    {
+        return static_cast<uint32_t>(GetUs() / 1000);
+    }
+
+    static uint32_t GetUs()
+    {
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+};
+
+struct Switch
+{
+    bool m_risingEdge = false;
+
+    bool RisingEdge() const
+    {
+        return m_risingEdge;
+    }
+};
+
+struct GateIn
+{
+    bool m_state = false;
+
+    bool State() const
+    {
+        return m_state;
+    }
+};
+
+struct AnalogControl
+{
+    float m_value = 0.0f;
+
+    float Process()
+    {
+        return m_value;
+    }
+
+    float Value() const
+    {
+        return m_value;
+    }
+};
+
+struct LedDriver
+{
+    void SetLed(size_t, float)
+    {
+    }
+
+    void SwapBuffersAndTransmit()
+    {
+    }
+};
+
+struct Display
+{
+    void Fill(bool)
+    {
+    }
+
+    void Update()
+    {
+    }
+
+    void SetCursor(uint8_t, uint8_t)
+    {
+    }
+
+    void WriteString(const char*, FontDef, bool)
+    {
+    }
+
+    void DrawRect(uint8_t, uint8_t, uint8_t, uint8_t, bool, bool)
+    {
+    }
+};
+
+struct DaisySeed
+{
+    void SetLed(bool)
+    {
+    }
+};
+
+struct DaisyField
+{
+    static constexpr size_t x_numKeys = 16;
+    static constexpr size_t x_numCvs = 4;
+
+    Switch sw[2];
+    GateIn gate_in;
+    AnalogControl knob[8];
+    LedDriver led_driver;
+    Display display;
+    DaisySeed seed;
+
+    bool m_keyState[x_numKeys] = {};
+    bool m_keyRisingEdge[x_numKeys] = {};
+    bool m_keyFallingEdge[x_numKeys] = {};
+    float m_cv[x_numCvs] = {};
+    uint16_t m_cvOut[2] = {};
+
+    void Init()
+    {
+    }
+
+    void StartAdc()
+    {
+    }
+
+    void StartAudio(AudioHandle::AudioCallback)
+    {
+    }
+
+    void ProcessAllControls()
+    {
+    }
+
+    // Host tools set state and edges, call DaisyIO::ProcessControls, then
+    // clear the edges so each press is seen once.
+    //
+    void PressKey(size_t idx, bool pressed)
+    {
+        m_keyRisingEdge[idx] = pressed && !m_keyState[idx];
+        m_keyFallingEdge[idx] = !pressed && m_keyState[idx];
+        m_keyState[idx] = pressed;
+    }
+
+    void ClearEdges()
+    {
+        for (size_t i = 0; i < x_numKeys; i++)
+        {
+            m_keyRisingEdge[i] = false;
+            m_keyFallingEdge[i] = false;
+        }
+
+        sw[0].m_risingEdge = false;
+        sw[1].m_risingEdge = false;
+    }
+
+    bool KeyboardState(size_t idx) const
+    {
+        return m_keyState[idx];
+    }
+
+    bool KeyboardRisingEdge(size_t idx) const
+    {
+        return m_keyRisingEdge[idx];
+    }
+
+    bool KeyboardFallingEdge(size_t idx) const
+    {
+        return m_keyFallingEdge[idx];
+    }
+
+    float GetCvValue(size_t idx) const
+    {
+        return m_cv[idx];
+    }
+
+    void SetCvOut1(uint16_t value)
+    {
+        m_cvOut[0] = value;
+    }
+
+    void SetCvOut2(uint16_t value)
+    {
+        m_cvOut[1] = value;
+    }
+};
+
+}
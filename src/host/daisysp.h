@@ -0,0 +1,4 @@
+#pragma once
+
+// Host stand-in for DaisySP. Nothing in this tree uses it directly.
+//
\ No newline at end of file
@@ -0,0 +1,48 @@
+# Host (Linux/macOS) build of the shared sources, for offline tools.
+# Uses the libDaisy stand-ins in src/host instead of the real library.
+
+BUILD_DIR ?= build
+
+HOST_CXX ?= c++
+
+REPO_ROOT := ../..
+
+INCLUDES_COMMON := \
+	-I$(REPO_ROOT)/src/host \
+	-I$(REPO_ROOT)/src/common
+
+INCLUDES := $(INCLUDES_COMMON) $(INCLUDES)
+
+DEFS := -DHOST_BUILD $(DEFS)
+
+CXXFLAGS := \
+	$(DEFS) \
+	$(INCLUDES) \
+	-O2 \
+	-g \
+	-std=gnu++17 \
+	-Wall \
+	-Wno-unused-variable \
+	$(CXXFLAGS)
+
+LDFLAGS := -pthread $(LDFLAGS)
+
+SRCS ?= main.cpp
+
+OBJS := $(SRCS:%.cpp=$(BUILD_DIR)/%.o)
+
+all: $(BUILD_DIR)/$(TARGET)
+
+$(BUILD_DIR):
+	mkdir -p $(BUILD_DIR)
+
+$(BUILD_DIR)/%.o: %.cpp | $(BUILD_DIR)
+	$(HOST_CXX) $(CXXFLAGS) -c $< -o $@
+
+$(BUILD_DIR)/$(TARGET): $(OBJS)
+	$(HOST_CXX) $^ $(LDFLAGS) -o $@
+
+clean:
+	rm -rf $(BUILD_DIR)
+
+.PHONY: all clean